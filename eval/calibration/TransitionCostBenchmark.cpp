@@ -0,0 +1,124 @@
+// Measures costs the partitioning objective is expressed in and writes them as a transition cost profile,
+// loaded by the partitioner with -cost-profile.
+//
+// Without an enclave at hand, a system call round trip stands in for an ecall/ocall transition,
+// as both switch the protection domain and back. Transitions measured on an enclave backend,
+// e.g. Asylo simulation, can be passed with --transition-ns and --backend.
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const std::size_t COPY_BUFFER_SIZE = 1 << 20;
+const unsigned REPETITIONS = 5;
+
+// Keeps compiler from removing benchmarked code
+volatile long sink;
+
+double elapsedNs(Clock::time_point start, Clock::time_point end)
+{
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+// Median over repetitions, to be robust to interruptions
+template <typename BenchmarkF>
+double measure(BenchmarkF benchmark)
+{
+    std::vector<double> results;
+    for (unsigned i = 0; i < REPETITIONS; ++i) {
+        results.push_back(benchmark());
+    }
+    std::sort(results.begin(), results.end());
+    return results[results.size() / 2];
+}
+
+double measureTransitionNs(unsigned iterations)
+{
+    return measure([iterations] () {
+        const auto start = Clock::now();
+        for (unsigned i = 0; i < iterations; ++i) {
+            sink = syscall(SYS_getppid);
+        }
+        return elapsedNs(start, Clock::now()) / iterations;
+    });
+}
+
+// Marshaling copies parameters into a freshly allocated message
+double measureByteCopyNs(unsigned iterations)
+{
+    std::vector<char> source(COPY_BUFFER_SIZE, 1);
+    const unsigned copies = std::max(1u, iterations / 1000);
+    return measure([&source, copies] () {
+        const auto start = Clock::now();
+        for (unsigned i = 0; i < copies; ++i) {
+            std::vector<char> message(source.size());
+            std::memcpy(message.data(), source.data(), source.size());
+            sink = message[i % message.size()];
+        }
+        return elapsedNs(start, Clock::now()) / (copies * (double) COPY_BUFFER_SIZE);
+    });
+}
+
+void printUsage(const char* name)
+{
+    std::cerr << "Usage: " << name << " [-o cost_profile.json] [-n iterations]"
+              << " [--transition-ns ns] [--backend name]\n";
+}
+
+} // unnamed namespace
+
+int main(int argc, char* argv[])
+{
+    std::string outFile = "cost_profile.json";
+    std::string backend = "local";
+    unsigned iterations = 1000000;
+    double transitionNs = -1;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 == argc) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        if (arg == "-o") {
+            outFile = argv[++i];
+        } else if (arg == "-n") {
+            iterations = std::max(1000, std::atoi(argv[++i]));
+        } else if (arg == "--transition-ns") {
+            transitionNs = std::atof(argv[++i]);
+        } else if (arg == "--backend") {
+            backend = argv[++i];
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (transitionNs < 0) {
+        transitionNs = measureTransitionNs(iterations);
+    }
+    const double byteCopyNs = measureByteCopyNs(iterations);
+
+    std::ofstream strm(outFile);
+    if (!strm.is_open()) {
+        std::cerr << "Can not open " << outFile << "\n";
+        return 1;
+    }
+    strm << "{\n"
+         << "    \"backend\": \"" << backend << "\",\n"
+         << "    \"transition_ns\": " << transitionNs << ",\n"
+         << "    \"byte_copy_ns\": " << byteCopyNs << "\n"
+         << "}\n";
+    std::cout << "transition " << transitionNs << "ns, copy " << byteCopyNs << "ns per byte\n";
+    return 0;
+}
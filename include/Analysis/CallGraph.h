@@ -8,22 +8,20 @@
 #include <functional>
 #include <memory>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace llvm {
 class Function;
 class CallGraph;
 class CallGraphNode;
-class LoopInfo;
-}
-
-namespace pdg {
-class PDG;
 }
 
 namespace vazgen {
 
 class Logger;
+class ModuleFacts;
+class PerformanceHints;
 
 class WeightFactor
 {
@@ -32,10 +30,12 @@ public:
         SENSITIVE = 0,
         SENSITIVE_RELATED,
         SIZE,
+        MEMORY_INTENSITY,
         CALL_NUM,
         ARG_NUM,
         ARG_COMPLEXITY,
         RET_COMPLEXITY,
+        MARSHALING_BYTES,
         UNKNOWN
     };
 public:
@@ -321,7 +321,6 @@ class CallGraph
 public:
     using NodeType = std::unique_ptr<Node>;
     using FunctionNodes = std::unordered_map<llvm::Function*, NodeType>;
-    using LoopInfoGetter = std::function<llvm::LoopInfo* (llvm::Function*)>;
     using iterator = FunctionNodes::iterator;
     using const_iterator = FunctionNodes::const_iterator;
 
@@ -339,8 +338,11 @@ public:
 
     void assignWeights(const Partition& securePartition,
                        const Partition& insecurePartition,
-                       const pdg::PDG* pdg,
-                       const LoopInfoGetter& loopInfoGetter);
+                       const ModuleFacts& moduleFacts,
+                       const PerformanceHints& hints);
+    // Adds edges of call sites with no called function, i.e. indirect calls and calls through bitcasts,
+    // which llvm::CallGraph routes through its external node
+    void addIndirectCallEdges(const Partition& securePartition, const ModuleFacts& moduleFacts);
 
 public:
     iterator begin()
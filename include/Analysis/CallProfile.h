@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace llvm {
+class Function;
+}
+
+namespace vazgen {
+
+class Logger;
+
+/**
+ * \class CallProfile
+ * \brief Caller/callee call counts recorded at run time by the shadow call stack instrumentation.
+ *
+ * Reads shadow_call_stack.txt files written by eval_library/ShadowStackBuilder.cpp,
+ * one "(caller callee) count" entry per line.
+ * Calls without a known caller, i.e. indirect calls and callbacks from external code, have "external" as caller.
+ */
+class CallProfile
+{
+public:
+    static const std::string EXTERNAL_CALLER;
+
+public:
+    explicit CallProfile(Logger& logger);
+
+    CallProfile(const CallProfile& ) = delete;
+    CallProfile(CallProfile&& ) = delete;
+    CallProfile& operator =(const CallProfile& ) = delete;
+    CallProfile& operator =(CallProfile&& ) = delete;
+
+public:
+    bool load(const std::string& fileName);
+
+    bool empty() const
+    {
+        return m_calls.empty();
+    }
+
+    // True if function was executed as caller or callee
+    bool hasFunction(llvm::Function* F) const;
+    // 0 for calls never recorded
+    double getCallsNum(llvm::Function* caller, llvm::Function* callee) const;
+    double getExternalCallsNum(llvm::Function* callee) const;
+    // Calls to F from all callers
+    double getEntriesNum(llvm::Function* F) const;
+
+private:
+    double getCallsNum(const std::string& caller, const std::string& callee) const;
+
+private:
+    Logger& m_logger;
+    // callee to caller to number of calls
+    std::unordered_map<std::string, std::unordered_map<std::string, double>> m_calls;
+    std::unordered_set<std::string> m_functions;
+}; // class CallProfile
+
+} // namespace vazgen
+
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Analysis/PDGSnapshot.h"
+#include "Analysis/SliceSummaries.h"
+#include "Utils/RingBuffer.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace pdg {
+class PDG;
+}
+
+namespace vazgen {
+
+/**
+ * \class ContextSensitiveSlicer
+ * \brief Interprocedural slicer in the style of Horwitz, Reps and Binkley.
+ *
+ * Edges from an actual argument node to a formal argument node of another function descend into a callee,
+ * edges from a formal argument node to an actual argument node of another function ascend to a caller.
+ * Summary edges connect actual argument nodes of one call site whenever a same level path through the callee
+ * links them. They are computed with a tabulation over (entry formal argument, node) path edges and memoized.
+ * Slicing runs in two phases: the first one ascends to callers and steps over call sites through summary edges,
+ * the second one descends into callees entered in the first phase without ascending back.
+ * Thus a value passing through a helper does not reach all callers of the helper.
+ * Node rules, i.e. where traversal stops and what gets into the summary, are the ones of SliceSummaries.
+ */
+class ContextSensitiveSlicer
+{
+public:
+    using PDGType = std::shared_ptr<pdg::PDG>;
+    using SummaryType = SliceSummaries::SummaryType;
+
+public:
+    ContextSensitiveSlicer(PDGType pdg, const PDGSnapshot& pdgSnapshot);
+
+    ContextSensitiveSlicer(const ContextSensitiveSlicer& ) = delete;
+    ContextSensitiveSlicer(ContextSensitiveSlicer&& ) = delete;
+    ContextSensitiveSlicer& operator =(const ContextSensitiveSlicer& ) = delete;
+    ContextSensitiveSlicer& operator =(ContextSensitiveSlicer&& ) = delete;
+
+public:
+    // Thread safe, slices are computed concurrently and only the memoized tabulation is locked
+    SummaryType slice(unsigned node, SliceSummaries::Direction direction);
+
+private:
+    enum EdgeKind {
+        INTRA,
+        DESCEND,
+        ASCEND,
+        OTHER
+    };
+
+    // Summary edges and tabulation state of one traversal direction
+    struct Tabulation
+    {
+        std::mutex mutex;
+        std::unordered_map<unsigned, std::vector<unsigned>> summaryEdges;
+        std::unordered_set<std::uint64_t> pathEdges;
+        // Entries having path edges to actual argument nodes
+        std::unordered_map<unsigned, std::vector<unsigned>> actualArgEntries;
+        RingBuffer<std::uint64_t> workingList;
+    }; // struct Tabulation
+
+    EdgeKind getEdgeKind(unsigned from, unsigned to) const;
+    PDGSnapshot::EdgeRange getNextNodes(unsigned node, bool forward) const;
+    PDGSnapshot::EdgeRange getPreviousNodes(unsigned node, bool forward) const;
+    bool canTraverse(unsigned node) const;
+
+    // Returns a copy, as other slices may add summary edges once the tabulation is unlocked
+    std::vector<unsigned> getSummaryEdges(unsigned actualArgNode, bool forward);
+    // Called with the tabulation of the direction locked
+    void tabulate(bool forward);
+    void addPathEdge(Tabulation& tabulation, unsigned entry, unsigned node);
+    void addSummaryEdge(Tabulation& tabulation, unsigned actualArgNode, unsigned target);
+
+private:
+    PDGType m_pdg;
+    const PDGSnapshot& m_pdgSnapshot;
+    Tabulation m_tabulations[2];
+}; // class ContextSensitiveSlicer
+
+} // namespace vazgen
+
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace llvm {
+class Function;
+class Module;
+}
+
+namespace vazgen {
+
+class Logger;
+class ModuleFacts;
+
+/**
+ * \class EnclaveSizing
+ * \brief Estimates stack, heap and TCS requirements of an extracted enclave module.
+ *
+ * Stack is the deepest chain of frames over the call graph of the enclave module,
+ * with indirect calls going to any address taken function and recursive SCCs counted a bounded number of times.
+ * Frame sizes are estimated from static allocas and a fixed overhead, as the enclave is compiled later.
+ * Heap is estimated from allocation sites in the enclave, with their sizes where those are constant.
+ * TCS count is a hint from thread creation sites of the whole program, each counted as many times as it is
+ * estimated to run, with a fixed number of threads for sites in loops of unknown trip count.
+ */
+class EnclaveSizing
+{
+public:
+    struct AllocationSite
+    {
+        llvm::Function* function;
+        // 0 if size is not constant
+        long size;
+    }; // struct AllocationSite
+
+public:
+    EnclaveSizing(llvm::Module& enclaveModule,
+                  llvm::Module& programModule,
+                  const ModuleFacts& programFacts,
+                  Logger& logger);
+
+    EnclaveSizing(const EnclaveSizing& ) = delete;
+    EnclaveSizing(EnclaveSizing&& ) = delete;
+    EnclaveSizing& operator =(const EnclaveSizing& ) = delete;
+    EnclaveSizing& operator =(EnclaveSizing&& ) = delete;
+
+public:
+    void estimate();
+    void dump(const std::string& fileName) const;
+
+    long getStackSize() const
+    {
+        return m_stackSize;
+    }
+
+    long getHeapSize() const
+    {
+        return m_heapSize;
+    }
+
+    unsigned getTCSNum() const
+    {
+        return m_tcsNum;
+    }
+
+private:
+    void estimateStack();
+    void estimateHeap();
+    void estimateTCSNum();
+    long getFrameSize(llvm::Function* F);
+    std::vector<llvm::Function*> getCallees(llvm::Function* F) const;
+
+private:
+    llvm::Module& m_enclaveModule;
+    llvm::Module& m_programModule;
+    const ModuleFacts& m_programFacts;
+    Logger& m_logger;
+    long m_maxStackDepth;
+    long m_stackSize;
+    long m_heapSize;
+    unsigned m_tcsNum;
+    bool m_hasDynamicAllocas;
+    std::vector<llvm::Function*> m_addressTakenFunctions;
+    std::vector<llvm::Function*> m_recursiveFunctions;
+    std::vector<AllocationSite> m_allocationSites;
+}; // class EnclaveSizing
+
+} // namespace vazgen
+
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+namespace llvm {
+class Function;
+class Module;
+}
+
+namespace vazgen {
+
+/**
+ * \class FunctionHashes
+ * \brief Content hashes of the functions of a module, telling which functions changed since an earlier run.
+ *
+ * A hash covers the signature and the printed instructions of a function, with values numbered locally.
+ * Debug intrinsics and metadata attachments are left out, so that edits shifting line numbers
+ * or metadata ids of other functions do not change their hashes.
+ * Hashes are MD5 based, so that they are stable across builds and standard libraries.
+ */
+class FunctionHashes
+{
+public:
+    // Function name to hash
+    using Hashes = std::unordered_map<std::string, std::uint64_t>;
+
+public:
+    explicit FunctionHashes(llvm::Module& M);
+
+    FunctionHashes(const FunctionHashes& ) = delete;
+    FunctionHashes(FunctionHashes&& ) = delete;
+    FunctionHashes& operator =(const FunctionHashes& ) = delete;
+    FunctionHashes& operator =(FunctionHashes&& ) = delete;
+
+public:
+    const Hashes& getHashes() const
+    {
+        return m_hashes;
+    }
+
+    std::uint64_t getHash(llvm::Function* F) const;
+
+private:
+    void computeHashes();
+
+private:
+    llvm::Module& m_module;
+    Hashes m_hashes;
+}; // class FunctionHashes
+
+} // namespace vazgen
+
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "Utils/ValueSet.h"
+
+#include <vector>
+
+namespace llvm {
+class Function;
+}
+
+namespace vazgen {
+
+/**
+ * \class InterfaceGraph
+ * \brief Caller to callee edges used to maintain partition interfaces incrementally.
+ *
+ * In-interface edges come from callees' call sites, out-interface edges come from callers' call instructions.
+ * The two relations are kept apart as they are collected from different parts of the PDG.
+ * Edges are indexed by caller function id in the module's function index, and an edge is listed once per call site.
+ */
+class InterfaceGraph
+{
+public:
+    using Edges = std::vector<unsigned>;
+
+public:
+    explicit InterfaceGraph(const ValueIndex<llvm::Function>& functionIndex)
+        : m_functionIndex(functionIndex)
+    {
+    }
+
+    InterfaceGraph(const InterfaceGraph& ) = delete;
+    InterfaceGraph(InterfaceGraph&& ) = delete;
+    InterfaceGraph& operator =(const InterfaceGraph& ) = delete;
+    InterfaceGraph& operator =(InterfaceGraph&& ) = delete;
+
+public:
+    const ValueIndex<llvm::Function>& getFunctionIndex() const
+    {
+        return m_functionIndex;
+    }
+
+    void addInInterfaceEdge(llvm::Function* caller, llvm::Function* callee)
+    {
+        addEdge(m_inInterfaceEdges, caller, callee);
+    }
+
+    void addOutInterfaceEdge(llvm::Function* caller, llvm::Function* callee)
+    {
+        addEdge(m_outInterfaceEdges, caller, callee);
+    }
+
+    const Edges& getInInterfaceEdges(unsigned callerId) const
+    {
+        return getEdges(m_inInterfaceEdges, callerId);
+    }
+
+    const Edges& getOutInterfaceEdges(unsigned callerId) const
+    {
+        return getEdges(m_outInterfaceEdges, callerId);
+    }
+
+    unsigned size() const
+    {
+        return std::max(m_inInterfaceEdges.size(), m_outInterfaceEdges.size());
+    }
+
+private:
+    void addEdge(std::vector<Edges>& edges, llvm::Function* caller, llvm::Function* callee)
+    {
+        const unsigned callerId = m_functionIndex.getId(caller);
+        const unsigned calleeId = m_functionIndex.getId(callee);
+        if (callerId == ValueIndex<llvm::Function>::INVALID_ID || calleeId == ValueIndex<llvm::Function>::INVALID_ID) {
+            return;
+        }
+        if (callerId >= edges.size()) {
+            edges.resize(callerId + 1);
+        }
+        edges[callerId].push_back(calleeId);
+    }
+
+    static const Edges& getEdges(const std::vector<Edges>& edges, unsigned callerId)
+    {
+        static const Edges noEdges;
+        return callerId < edges.size() ? edges[callerId] : noEdges;
+    }
+
+private:
+    const ValueIndex<llvm::Function>& m_functionIndex;
+    std::vector<Edges> m_inInterfaceEdges;
+    std::vector<Edges> m_outInterfaceEdges;
+}; // class InterfaceGraph
+
+} // namespace vazgen
+
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+namespace llvm {
+class Function;
+}
+
+namespace vazgen {
+
+class Logger;
+
+/**
+ * \class LibraryCalls
+ * \brief Placement of external library functions with respect to the enclave.
+ *
+ * Enclave safe functions, e.g. memory, string and math routines, have copies in the trusted libc
+ * and are called in place from both partitions, so calls to them never cross the boundary.
+ * Functions doing I/O or system calls require an ocall from the enclave, forbidden ones,
+ * e.g. process creation, can not be called from it at all. LLVM intrinsics are enclave safe
+ * and unknown external functions require an ocall.
+ * Built-in classification can be extended and overridden with the json file given by -library-calls:
+ * {"enclave_safe": [names], "requires_ocall": [names], "forbidden": [names]}.
+ */
+class LibraryCalls
+{
+public:
+    enum Placement : std::uint8_t {
+        ENCLAVE_SAFE = 0,
+        REQUIRES_OCALL,
+        FORBIDDEN
+    };
+
+public:
+    static const LibraryCalls& get();
+
+    LibraryCalls(const LibraryCalls& ) = delete;
+    LibraryCalls(LibraryCalls&& ) = delete;
+    LibraryCalls& operator =(const LibraryCalls& ) = delete;
+    LibraryCalls& operator =(LibraryCalls&& ) = delete;
+
+public:
+    // Placement of a declaration. Defined functions are placed by partitioning
+    Placement getPlacement(const llvm::Function* F) const;
+
+    bool isEnclaveSafe(const llvm::Function* F) const;
+    bool isForbidden(const llvm::Function* F) const;
+
+private:
+    LibraryCalls();
+
+    void addBuiltins();
+    void load(const std::string& fileName, Logger& logger);
+
+private:
+    std::unordered_map<std::string, Placement> m_placements;
+}; // class LibraryCalls
+
+} // namespace vazgen
+
@@ -0,0 +1,217 @@
+#pragma once
+
+#include "Utils/ValueSet.h"
+
+#include "llvm/IR/CallSite.h"
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace llvm {
+class BasicBlock;
+class BlockFrequencyInfo;
+class DataLayout;
+class Function;
+class GlobalVariable;
+class LoopInfo;
+class Module;
+class ScalarEvolution;
+class TargetTransformInfo;
+class Type;
+}
+
+namespace pdg {
+class PDG;
+}
+
+namespace vazgen {
+
+class FunctionHashes;
+class Logger;
+
+/**
+ * \class ModuleFacts
+ * \brief Per function facts of a module, collected once and shared by partitioning, optimizations and statistics.
+ *
+ * ModuleFacts owns the indices giving dense ids to functions and globals of the module, assigned once at construction.
+ * Facts are stored in arrays indexed by function ids:
+ * function size in instructions and in estimated machine code bytes,
+ * argument and return type complexity, bytes marshaled across the enclave boundary
+ * per call, memory operations executed per entry and the call sites of each function
+ * together with the loop depth and the estimated frequency of the calling block.
+ * Call sites are taken from the PDG, so they are the same call sites partition interfaces are computed from.
+ * These include indirect call sites, resolved with points-to sets of SVF.
+ * Block frequencies are relative to the entry of the caller, taken from BlockFrequencyInfo
+ * and corrected with ScalarEvolution trip counts of enclosing loops where those are known.
+ * Function frequencies are propagated from main over the call sites, main and functions without call sites
+ * are entered once.
+ * With -persist-module-facts, facts computed from function analyses are kept in <module>.facts.json
+ * and reused for functions with unchanged content hashes, so that analyses run for changed functions only.
+ */
+class ModuleFacts
+{
+public:
+    // Analyses of one function. Any of them may be null
+    struct FunctionAnalyses
+    {
+        llvm::LoopInfo* loopInfo = nullptr;
+        llvm::BlockFrequencyInfo* blockFrequency = nullptr;
+        llvm::ScalarEvolution* scalarEvolution = nullptr;
+        const llvm::TargetTransformInfo* targetTransformInfo = nullptr;
+    }; // struct FunctionAnalyses
+
+    // Analyses returned for a function are valid until the getter is called for another function
+    using FunctionAnalysesGetter = std::function<FunctionAnalyses (llvm::Function*)>;
+
+    struct CallSiteFact
+    {
+        llvm::CallSite callSite;
+        llvm::Function* caller;
+        // 0 if call site is not in a loop
+        unsigned loopDepth;
+        // Estimated executions per entry of the caller. Split evenly across possible targets of indirect calls
+        double frequency;
+        // Call site may call other functions than F. Calls through a bitcast of F are not indirect,
+        // though they have no called function
+        bool indirect;
+    }; // struct CallSiteFact
+
+    using CallSiteFacts = std::vector<CallSiteFact>;
+
+public:
+    ModuleFacts(llvm::Module& M,
+                const pdg::PDG& pdg,
+                const FunctionAnalysesGetter& analysesGetter,
+                Logger& logger);
+
+    ModuleFacts(const ModuleFacts& ) = delete;
+    ModuleFacts(ModuleFacts&& ) = delete;
+    ModuleFacts& operator =(const ModuleFacts& ) = delete;
+    ModuleFacts& operator =(ModuleFacts&& ) = delete;
+
+public:
+    const ValueIndex<llvm::Function>& getFunctionIndex() const
+    {
+        return m_functionIndex;
+    }
+
+    const ValueIndex<llvm::GlobalVariable>& getGlobalsIndex() const
+    {
+        return m_globalsIndex;
+    }
+
+    int getFunctionSize(llvm::Function* F) const;
+    // Estimated bytes of machine code of F, what F takes in EPC
+    long getCodeSize(llvm::Function* F) const;
+    int getArgComplexity(llvm::Function* F) const;
+    int getReturnComplexity(llvm::Function* F) const;
+    // Bytes copied for arguments of a call to F, pointees in and, unless read only, back out
+    long getArgBytes(llvm::Function* F) const;
+    long getReturnBytes(llvm::Function* F) const;
+    // Loads, stores, atomics and memory intrinsics executed per entry to F, weighted by block frequencies
+    double getMemoryOperations(llvm::Function* F) const;
+    // Call sites calling F
+    const CallSiteFacts& getCallSites(llvm::Function* F) const;
+    bool hasCallSiteInLoop(llvm::Function* F, llvm::Function* caller) const;
+    // True if F calls a forbidden library function, directly, through a cast or indirectly.
+    // Such functions can not run in the enclave
+    bool callsForbiddenFunction(llvm::Function* F) const;
+    // Estimated number of entries to F in a run of the program
+    double getFunctionFrequency(llvm::Function* F) const;
+    // Estimated executions of block per entry of its function, 1 for blocks of unknown functions
+    double getBlockFrequency(llvm::BasicBlock* block) const;
+    // False if block is in a loop whose trip count is not known statically, so its frequency is a guess
+    bool hasKnownTripCounts(llvm::BasicBlock* block) const;
+    // Estimated number of calls from caller to F in a run of the program
+    double getCallFrequency(llvm::Function* F, llvm::Function* caller) const;
+
+    // Sum of sizes of defined functions
+    long getModuleSize() const;
+    long getModuleCodeSize() const;
+
+    // Number of scalar values a value of given type is made of. Pointers and functions are not counted
+    int getTypeComplexity(llvm::Type* type) const;
+
+private:
+    struct FunctionFacts
+    {
+        int m_size = 0;
+        long m_codeSize = 0;
+        int m_argComplexity = 0;
+        int m_retComplexity = 0;
+        long m_argBytes = 0;
+        long m_retBytes = 0;
+        double m_memoryOps = 0;
+        double m_frequency = 0;
+        bool m_callsForbidden = false;
+        CallSiteFacts m_callSites;
+    }; // struct FunctionFacts
+
+    struct BlockFacts
+    {
+        unsigned m_loopDepth = 0;
+        // Estimated executions per entry of the function
+        double m_frequency = 1;
+        bool m_tripCountsKnown = true;
+    }; // struct BlockFacts
+
+    // Facts computed from analyses of a function, depending on its content only
+    struct AnalysedFacts
+    {
+        long m_codeSize = 0;
+        double m_memoryOps = 0;
+        // In the order of basic blocks of the function
+        std::vector<BlockFacts> m_blocks;
+    }; // struct AnalysedFacts
+
+    using AnalysedFactsCache = std::unordered_map<llvm::Function*, AnalysedFacts>;
+
+    void collectFunctionFacts(llvm::Module& M);
+    // Facts depending on function analyses: call sites and memory operations.
+    // Functions missing from the cache are analysed and added to it
+    void collectBlockFacts(llvm::Module& M,
+                           const pdg::PDG& pdg,
+                           const FunctionAnalysesGetter& analysesGetter,
+                           AnalysedFactsCache& cache);
+    void collectForbiddenCalls(llvm::Module& M);
+    void collectMemoryFacts(llvm::Function* F, const FunctionAnalyses& analyses, AnalysedFacts& facts);
+    void collectCodeSize(llvm::Function* F, const FunctionAnalyses& analyses, AnalysedFacts& facts);
+    double computeBlockFrequency(llvm::BasicBlock* block, const FunctionAnalyses& analyses) const;
+    bool computeTripCountsKnown(llvm::BasicBlock* block, const FunctionAnalyses& analyses) const;
+    void computeFunctionFrequencies(llvm::Module& M);
+    void loadAnalysedFacts(llvm::Module& M,
+                           const std::string& fileName,
+                           const FunctionHashes& hashes,
+                           AnalysedFactsCache& cache) const;
+    void saveAnalysedFacts(const std::string& fileName,
+                           const FunctionHashes& hashes,
+                           const AnalysedFactsCache& cache) const;
+    const FunctionFacts* getFacts(llvm::Function* F) const;
+    FunctionFacts& getMutableFacts(llvm::Function* F);
+    int computeTypeComplexity(llvm::Type* type);
+    // Size of value of given type together with pointees the generated wrappers deep copy
+    long computeMarshalingBytes(llvm::Type* type, const llvm::DataLayout& dataLayout);
+    long computeMarshalingBytes(llvm::Type* type,
+                                const llvm::DataLayout& dataLayout,
+                                std::unordered_set<llvm::Type*>& pointees,
+                                std::unordered_map<llvm::Type*, long>& truncatedBytes,
+                                bool& truncated);
+
+private:
+    Logger& m_logger;
+    const ValueIndex<llvm::Function> m_functionIndex;
+    const ValueIndex<llvm::GlobalVariable> m_globalsIndex;
+    std::vector<FunctionFacts> m_functionFacts;
+    std::unordered_map<const llvm::BasicBlock*, BlockFacts> m_blockFacts;
+    long m_moduleSize;
+    long m_moduleCodeSize;
+    // aggregate types are shared by many functions, their complexities are computed once at construction
+    std::unordered_map<llvm::Type*, int> m_typeComplexities;
+    std::unordered_map<llvm::Type*, long> m_typeBytes;
+}; // class ModuleFacts
+
+} // namespace vazgen
+
@@ -0,0 +1,206 @@
+#pragma once
+
+#include "Utils/ValueSet.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace llvm {
+class Function;
+class Instruction;
+class Module;
+class Value;
+}
+
+namespace pdg {
+class PDG;
+class PDGNode;
+}
+
+namespace vazgen {
+
+/**
+ * \class PDGSnapshot
+ * \brief Immutable flattening of the PDG into integer node ids and CSR edge arrays.
+ *
+ * Node kinds, values and parent functions are resolved once when the snapshot is taken, functions by their ids
+ * in the module's function index,
+ * so traversals work on plain arrays without shared_ptr chasing, dyn_casts or hashing.
+ * Edges of each node are stored contiguously, data edges first, then control edges.
+ * The snapshot is read-only after construction and can be shared by concurrent traversals.
+ */
+class PDGSnapshot
+{
+public:
+    static constexpr unsigned INVALID_NODE = ~0u;
+
+    enum NodeKind : std::uint8_t {
+        NON_LLVM = 0,
+        LLVM,
+        INSTRUCTION,
+        FUNCTION,
+        FORMAL_ARG,
+        ACTUAL_ARG,
+        CONSTANT,
+        NULL_NODE
+    };
+
+    class EdgeRange
+    {
+    public:
+        EdgeRange(const unsigned* begin, const unsigned* end)
+            : m_begin(begin)
+            , m_end(end)
+        {
+        }
+
+        const unsigned* begin() const
+        {
+            return m_begin;
+        }
+
+        const unsigned* end() const
+        {
+            return m_end;
+        }
+
+        bool empty() const
+        {
+            return m_begin == m_end;
+        }
+
+    private:
+        const unsigned* m_begin;
+        const unsigned* m_end;
+    }; // class EdgeRange
+
+public:
+    PDGSnapshot(llvm::Module& M, const pdg::PDG& pdg, const ValueIndex<llvm::Function>& functionIndex);
+
+    PDGSnapshot(const PDGSnapshot& ) = delete;
+    PDGSnapshot(PDGSnapshot&& ) = delete;
+    PDGSnapshot& operator =(const PDGSnapshot& ) = delete;
+    PDGSnapshot& operator =(PDGSnapshot&& ) = delete;
+
+public:
+    unsigned size() const
+    {
+        return m_kinds.size();
+    }
+
+    const ValueIndex<llvm::Function>& getFunctionIndex() const
+    {
+        return m_functionIndex;
+    }
+
+    unsigned getNodeId(pdg::PDGNode* node) const;
+
+    NodeKind getKind(unsigned id) const
+    {
+        return static_cast<NodeKind>(m_kinds[id]);
+    }
+
+    bool isLLVMNode(unsigned id) const
+    {
+        return m_kinds[id] != NON_LLVM;
+    }
+
+    // Nodes traversals do not go through
+    bool canProcessNode(unsigned id) const
+    {
+        return m_kinds[id] != CONSTANT && m_kinds[id] != NULL_NODE;
+    }
+
+    llvm::Value* getValue(unsigned id) const
+    {
+        return m_values[id];
+    }
+
+    // Function node belongs to, as given by PDGNode::getParent
+    llvm::Function* getParent(unsigned id) const
+    {
+        return getFunction(m_parents, id);
+    }
+
+    // Function of function and formal argument nodes
+    llvm::Function* getNodeFunction(unsigned id) const
+    {
+        return getFunction(m_nodeFunctions, id);
+    }
+
+    // True for actual argument nodes of pointer arguments
+    bool isPointerActualArg(unsigned id) const
+    {
+        return m_pointerActualArgs[id];
+    }
+
+    // Call instruction of actual argument nodes
+    llvm::Instruction* getCallSite(unsigned id) const
+    {
+        auto pos = m_callSites.find(id);
+        return pos == m_callSites.end() ? nullptr : pos->second;
+    }
+
+    EdgeRange getOutEdges(unsigned id) const
+    {
+        return EdgeRange(m_outEdges.data() + m_outOffsets[id], m_outEdges.data() + m_outOffsets[id + 1]);
+    }
+
+    EdgeRange getOutDataEdges(unsigned id) const
+    {
+        return EdgeRange(m_outEdges.data() + m_outOffsets[id], m_outEdges.data() + m_outControlOffsets[id]);
+    }
+
+    EdgeRange getOutControlEdges(unsigned id) const
+    {
+        return EdgeRange(m_outEdges.data() + m_outControlOffsets[id], m_outEdges.data() + m_outOffsets[id + 1]);
+    }
+
+    EdgeRange getInEdges(unsigned id) const
+    {
+        return EdgeRange(m_inEdges.data() + m_inOffsets[id], m_inEdges.data() + m_inOffsets[id + 1]);
+    }
+
+    EdgeRange getInDataEdges(unsigned id) const
+    {
+        return EdgeRange(m_inEdges.data() + m_inOffsets[id], m_inEdges.data() + m_inControlOffsets[id]);
+    }
+
+    EdgeRange getInControlEdges(unsigned id) const
+    {
+        return EdgeRange(m_inEdges.data() + m_inControlOffsets[id], m_inEdges.data() + m_inOffsets[id + 1]);
+    }
+
+private:
+    unsigned addNode(pdg::PDGNode* node);
+    void addEdges(pdg::PDGNode* node);
+    unsigned getFunctionId(llvm::Function* F) const;
+
+    llvm::Function* getFunction(const std::vector<unsigned>& functionIds, unsigned id) const
+    {
+        const unsigned functionId = functionIds[id];
+        return functionId == ValueIndex<llvm::Function>::INVALID_ID ? nullptr : m_functionIndex.getValue(functionId);
+    }
+
+private:
+    const ValueIndex<llvm::Function>& m_functionIndex;
+    std::unordered_map<pdg::PDGNode*, unsigned> m_nodeIds;
+    std::vector<pdg::PDGNode*> m_nodes;
+    std::vector<std::uint8_t> m_kinds;
+    std::vector<llvm::Value*> m_values;
+    std::vector<unsigned> m_parents;
+    std::vector<unsigned> m_nodeFunctions;
+    std::vector<bool> m_pointerActualArgs;
+    std::unordered_map<unsigned, llvm::Instruction*> m_callSites;
+
+    std::vector<unsigned> m_outOffsets;
+    std::vector<unsigned> m_outControlOffsets;
+    std::vector<unsigned> m_outEdges;
+    std::vector<unsigned> m_inOffsets;
+    std::vector<unsigned> m_inControlOffsets;
+    std::vector<unsigned> m_inEdges;
+}; // class PDGSnapshot
+
+} // namespace vazgen
+
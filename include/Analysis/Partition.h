@@ -1,6 +1,10 @@
 #pragma once
 
-#include <unordered_set>
+#include "Analysis/InterfaceGraph.h"
+#include "Utils/ValueSet.h"
+
+#include <memory>
+#include <string>
 #include <unordered_map>
 
 namespace llvm {
@@ -10,16 +14,40 @@ class GlobalVariable;
 
 namespace vazgen {
 
+class ModuleFacts;
+
+/**
+ * \class Partition
+ * \brief Set of functions and globals belonging to one side of the program partition.
+ *
+ * Function and global sets are dense bitsets over the module's indices in ModuleFacts,
+ * so membership, union and difference are word-parallel.
+ * Partition data is copy-on-write: copying a partition is a pointer copy, and the data is cloned
+ * only on the first modification of a shared copy. Optimizers can snapshot candidate partitions freely.
+ * Copies sharing data must not be modified from different threads, as detaching checks the use count without synchronization.
+ *
+ * Once an InterfaceGraph is attached, in and out interfaces are maintained incrementally.
+ * For every function the partition counts in-interface call edges coming from outside of it, and
+ * out-interface call edges coming from inside of it, so adding or removing a function costs O(degree).
+ */
 class Partition
 {
 public:
-    using FunctionSet = std::unordered_set<llvm::Function*>;
-    using GlobalsSet = std::unordered_set<llvm::GlobalVariable*>;
+    using FunctionSet = ValueSet<llvm::Function>;
+    using GlobalsSet = ValueSet<llvm::GlobalVariable>;
+    using RelatedFunctions = std::unordered_map<llvm::Function*, int>;
+    using InterfaceGraphType = std::shared_ptr<const InterfaceGraph>;
 
 public:
-    Partition() = default;
+    // Empty partition of no module, to be assigned or merged into
+    Partition();
+    explicit Partition(const ModuleFacts& moduleFacts);
 
 public:
+    // Attaches call edges and recomputes interfaces. Interfaces are kept up to date from then on.
+    void setInterfaceGraph(InterfaceGraphType graph);
+    bool hasInterfaceGraph() const;
+
     void setPartition(const FunctionSet& functions);
     void setInInterface(const FunctionSet& functions);
     void setOutInterface(const FunctionSet& functions);
@@ -30,12 +58,14 @@ public:
     void setOutInterface(FunctionSet&& functions);
     void setGlobals(GlobalsSet&& globals);
 
+    // F has to be in the function index of ModuleFacts
     void addToPartition(llvm::Function* F);
     void addToPartition(const FunctionSet& functions);
     void addToPartition(const Partition& partition);
     void addRelatedFunction(llvm::Function* F, int level);
 
     void removeFromPartition(llvm::Function* F);
+    void removeFromPartition(const FunctionSet& functions);
     void removeRelatedFunction(llvm::Function* F);
     void clearRelatedFunctions();
 
@@ -43,7 +73,7 @@ public:
     const FunctionSet& getInInterface() const;
     const FunctionSet& getOutInterface() const;
     const GlobalsSet& getGlobals() const;
-    const std::unordered_map<llvm::Function*, int> getRelatedFunctions() const;
+    const RelatedFunctions& getRelatedFunctions() const;
     int getFunctionRelationLevel(llvm::Function* F) const;
 
     bool contains(llvm::Function* F) const;
@@ -53,14 +83,32 @@ public:
     bool references(llvm::GlobalVariable* global) const;
 
 private:
+    struct Data
+    {
+        RelatedFunctions m_relatedFunctions;
+        FunctionSet m_partition;
+        FunctionSet m_inInterface;
+        FunctionSet m_outInterface;
+        GlobalsSet m_partitionGlobals;
+        InterfaceGraphType m_interfaceGraph;
+        // per function id, number of in-interface call edges from functions outside of the partition
+        std::vector<int> m_outsideCallers;
+        // per function id, number of out-interface call edges from functions in the partition
+        std::vector<int> m_insideCallers;
+    }; // struct Data
+
+    // Returns data safe to modify, cloning it if it is shared with other copies
+    Data& getMutableData();
     void addRelatedFunctions(const Partition& partition);
 
+    void computeInterfaces(Data& data);
+    void addFunction(Data& data, unsigned id);
+    void removeFunction(Data& data, unsigned id);
+    void updateCallers(Data& data, unsigned id, int delta);
+    void updateInterfaces(Data& data, unsigned id);
+
 private:
-    std::unordered_map<llvm::Function*, int> m_relatedFunctions;
-    FunctionSet m_partition;
-    FunctionSet m_inInterface;
-    FunctionSet m_outInterface;
-    GlobalsSet m_partitionGlobals;
+    std::shared_ptr<Data> m_data;
 }; // class Partition
 
 } // namespace vazgen
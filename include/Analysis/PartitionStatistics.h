@@ -14,6 +14,7 @@ namespace vazgen {
 
 class Partition;
 class CallGraph;
+class ModuleFacts;
 
 class PartitionStatistics : public Statistics
 {
@@ -22,6 +23,7 @@ public:
                         const Partition& securePartition,
                         const Partition& insecurePartition,
                         const CallGraph& callgraph,
+                        const ModuleFacts& moduleFacts,
                         llvm::Module& M);
 
     void report() final;
@@ -36,6 +38,9 @@ private:
     void reportNumOfContextSwitches(const Partition& partition);
     void reportSizeOfTCB(const Partition& partition);
     void repotArgsPassedAccrossPartition(const Partition& partition);
+    void reportMarshaledBytes(const Partition& partition);
+    // Library functions the partition has to leave for or must not call
+    void reportLibraryCalls(const Partition& partition);
 
     Double getCtxSwitchesInFunction(llvm::Function* F, const Partition& partition);
     Double getArgNumPassedFromFunction(llvm::Function* F, const Partition& partition);
@@ -45,8 +50,8 @@ private:
     const Partition& m_securePartition;
     const Partition& m_insecurePartition;
     const CallGraph& m_callgraph;
+    const ModuleFacts& m_moduleFacts;
     llvm::Module& m_module;
-    unsigned m_moduleSize;
 }; // class PartitionStatistics
 
 
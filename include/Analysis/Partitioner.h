@@ -18,6 +18,9 @@ class PDG;
 namespace vazgen {
 
 class Logger;
+class ModuleFacts;
+class PDGSnapshot;
+class SliceSummaries;
 
 /// For internal uses only
 class Partitioner
@@ -28,20 +31,23 @@ public:
     using PDGType = std::shared_ptr<pdg::PDG>;
 
 public:
-    Partitioner(llvm::Module& M, PDGType pdg, Logger& logger)
+    Partitioner(llvm::Module& M, PDGType pdg, const ModuleFacts& moduleFacts, Logger& logger)
         : m_module(M)
         , m_pdg(pdg)
+        , m_moduleFacts(moduleFacts)
         , m_logger(logger)
+        , m_securePartition(moduleFacts)
+        , m_insecurePartition(moduleFacts)
     {
     }
 
 public:
-    Partition getSecurePartition() const
+    const Partition& getSecurePartition() const
     {
         return m_securePartition;
     }
 
-    Partition getInsecurePartition() const
+    const Partition& getInsecurePartition() const
     {
         return m_insecurePartition;
     }
@@ -50,11 +56,20 @@ public:
     void partition(const Annotations& annotations);
 
 private:
-    void computeInsecurePartition();
+    // Slices the PDG for each annotation separately, annotations are processed concurrently
+    Partition sliceAnnotations(const Annotations& annotations, SliceSummaries& summaries);
+    // Slices the PDG for all annotations in a single propagation of annotation bitmasks
+    void propagateAnnotations(const Annotations& annotations, const PDGSnapshot& pdgSnapshot);
+    // Slices the PDG for a single annotation and adds the result to the given partition
+    void partition(const Annotation& annotation, SliceSummaries& summaries, Partition& partition) const;
+    void reportSlicingReduction(const Partition& partition, const Partition& baselinePartition) const;
+    void computeInsecurePartition(Partition::InterfaceGraphType interfaceGraph);
+    void partitionGlobals();
 
 protected:
     llvm::Module& m_module;
     PDGType m_pdg;
+    const ModuleFacts& m_moduleFacts;
     Logger& m_logger;
     Partition m_securePartition;
     Partition m_insecurePartition;
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "Analysis/Partition.h"
+
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace llvm {
+class Function;
+}
+
+namespace vazgen {
+
+class Annotation;
+class Logger;
+class ModuleFacts;
+
+/**
+ * \class PerformanceHints
+ * \brief Performance hint annotations of a module, applied to partitions and call graph weights.
+ *
+ * Pinned functions and latency critical calls are hard constraints: optimizers do not move pinned functions
+ * and enforce() restores the constraints optimizers can not express.
+ * Sensitivity wins over hints, functions the secure partition needs for security are never moved out of it.
+ * Call rates override estimated call numbers of call graph edges.
+ */
+class PerformanceHints
+{
+public:
+    using Call = std::pair<llvm::Function*, llvm::Function*>;
+
+public:
+    PerformanceHints(const std::vector<Annotation>& annotations, const ModuleFacts& moduleFacts, Logger& logger);
+
+    PerformanceHints(const PerformanceHints& ) = delete;
+    PerformanceHints(PerformanceHints&& ) = delete;
+    PerformanceHints& operator =(const PerformanceHints& ) = delete;
+    PerformanceHints& operator =(PerformanceHints&& ) = delete;
+
+public:
+    bool empty() const;
+
+    bool isPinnedToEnclave(llvm::Function* F) const
+    {
+        return m_enclavePinned.contains(F);
+    }
+
+    bool isPinnedUntrusted(llvm::Function* F) const
+    {
+        return m_untrustedPinned.contains(F);
+    }
+
+    // Pinned to either side, optimizers must not move it
+    bool isPinned(llvm::Function* F) const
+    {
+        return isPinnedToEnclave(F) || isPinnedUntrusted(F);
+    }
+
+    bool hasCallRate(llvm::Function* F) const
+    {
+        return m_callRates.find(F) != m_callRates.end();
+    }
+
+    // Expected calls to F per run
+    double getCallRate(llvm::Function* F) const;
+
+    bool isLatencyCritical(llvm::Function* caller, llvm::Function* callee) const;
+
+    const Partition::FunctionSet& getEnclavePinned() const
+    {
+        return m_enclavePinned;
+    }
+
+    const Partition::FunctionSet& getUntrustedPinned() const
+    {
+        return m_untrustedPinned;
+    }
+
+    // Adds functions pinned to the enclave to the secure partition
+    void pin(Partition& securePartition, Partition& insecurePartition) const;
+    // Moves functions so that pins and latency critical calls hold after optimization.
+    // Functions of sensitivePartition, the secure partition before optimization, are kept in the enclave,
+    // callers of forbidden library functions are kept out of it
+    void enforce(Partition& securePartition,
+                 Partition& insecurePartition,
+                 const Partition::FunctionSet& sensitivePartition) const;
+
+private:
+    void moveToEnclave(llvm::Function* F, Partition& securePartition, Partition& insecurePartition) const;
+    void moveOutOfEnclave(llvm::Function* F, Partition& securePartition, Partition& insecurePartition) const;
+
+private:
+    const ModuleFacts& m_moduleFacts;
+    Logger& m_logger;
+    Partition::FunctionSet m_enclavePinned;
+    Partition::FunctionSet m_untrustedPinned;
+    std::unordered_map<llvm::Function*, double> m_callRates;
+    // Callees with all calls latency critical
+    Partition::FunctionSet m_latencyCriticalCallees;
+    std::set<Call> m_latencyCriticalCalls;
+}; // class PerformanceHints
+
+} // namespace vazgen
+
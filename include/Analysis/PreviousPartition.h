@@ -0,0 +1,70 @@
+#pragma once
+
+#include <iosfwd>
+#include <string>
+#include <unordered_set>
+
+namespace llvm {
+class Function;
+}
+
+namespace vazgen {
+
+class Logger;
+class Partition;
+
+/**
+ * \class PreviousPartition
+ * \brief Placement of functions in an earlier partitioning run, used to keep re-optimized partitions stable.
+ *
+ * Loaded either from partition_stats.json written by -dump-stats, or from the file written by -outfile.
+ * The latter lists secure functions only, all other functions are taken as insecure.
+ * Functions are matched by name, functions missing from the previous run have no placement.
+ * Cost based optimizers pay the churn penalty for each function placed differently than before.
+ */
+class PreviousPartition
+{
+public:
+    PreviousPartition(double churnPenalty, Logger& logger);
+
+    PreviousPartition(const PreviousPartition& ) = delete;
+    PreviousPartition(PreviousPartition&& ) = delete;
+    PreviousPartition& operator =(const PreviousPartition& ) = delete;
+    PreviousPartition& operator =(PreviousPartition&& ) = delete;
+
+public:
+    bool load(const std::string& fileName);
+
+    bool empty() const
+    {
+        return m_secureFunctions.empty() && m_insecureFunctions.empty();
+    }
+
+    double getChurnPenalty() const
+    {
+        return m_churnPenalty;
+    }
+
+    // True if F was placed in either partition
+    bool hasFunction(llvm::Function* F) const;
+    bool wasSecure(llvm::Function* F) const;
+    // Churn cost of placing F in the enclave instead of outside, negative if it was in the enclave
+    double getMoveToEnclaveCost(llvm::Function* F) const;
+    // Functions placed differently than in the previous run
+    unsigned getMovedFunctionsNum(const Partition& securePartition, const Partition& insecurePartition) const;
+
+private:
+    bool loadStats(std::ifstream& ifs, const std::string& fileName);
+    bool loadPartitionDump(std::ifstream& ifs, const std::string& fileName);
+
+private:
+    const double m_churnPenalty;
+    Logger& m_logger;
+    std::unordered_set<std::string> m_secureFunctions;
+    std::unordered_set<std::string> m_insecureFunctions;
+    // Partition dumps do not list insecure functions
+    bool m_hasInsecureFunctions;
+}; // class PreviousPartition
+
+} // namespace vazgen
+
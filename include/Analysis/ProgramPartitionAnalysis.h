@@ -2,6 +2,7 @@
 
 #include "Partition.h"
 #include "CallGraph.h"
+#include "ModuleFacts.h"
 
 #include "llvm/Pass.h"
 #include "PDG/PDG/PDG.h"
@@ -21,10 +22,14 @@ namespace vazgen {
 
 class Annotation;
 class Logger;
+class PerformanceHints;
+class PreviousPartition;
 
 /**
  * \class ProgramPartition
  * \brief Partitions given Module based on user annotations
+ *
+ * Sensitivity annotations drive partitioning, performance hint annotations are applied on top of it.
  */
 class ProgramPartition
 {
@@ -32,13 +37,15 @@ public:
     // TODO: what is partition does not only include functions but for example also global variables?
     using Annotations = std::vector<Annotation>;
     using PDGType = std::shared_ptr<pdg::PDG>;
-    using LoopInfoGetter = std::function<llvm::LoopInfo* (llvm::Function*)>;
+    using FunctionAnalysesGetter = ModuleFacts::FunctionAnalysesGetter;
+    using GlobalSetters = std::unordered_set<llvm::Function*>;
 
 public:
     ProgramPartition(llvm::Module& M, PDGType pdg,
                      const llvm::CallGraph& callGraph,
-                     const LoopInfoGetter& loopInfoGetter,
+                     const FunctionAnalysesGetter& analysesGetter,
                      Logger& logger);
+    ~ProgramPartition();
 
     ProgramPartition(const ProgramPartition& ) = delete;
     ProgramPartition(ProgramPartition&& ) = delete;
@@ -47,6 +54,8 @@ public:
 
 
 public:
+    // Placement of an earlier run, re-optimization pays churnPenalty for each function placed differently
+    bool loadPreviousPartition(const std::string& fileName, double churnPenalty);
     void partition(const Annotations& annotations);
     void optimize(auto optimizations);
 
@@ -70,6 +79,38 @@ public:
         return m_insecurePartition;
     }
 
+    const ModuleFacts& getModuleFacts() const
+    {
+        return *m_moduleFacts;
+    }
+
+    const PerformanceHints& getPerformanceHints() const
+    {
+        return *m_hints;
+    }
+
+    // Setters of globals created by partition extraction.
+    // They are created after ModuleFacts, so they are not in the partitions and are kept here.
+    void setSecureGlobalSetters(GlobalSetters&& setters)
+    {
+        m_secureGlobalSetters = std::move(setters);
+    }
+
+    const GlobalSetters& getSecureGlobalSetters() const
+    {
+        return m_secureGlobalSetters;
+    }
+
+    void setInsecureGlobalSetters(GlobalSetters&& setters)
+    {
+        m_insecureGlobalSetters = std::move(setters);
+    }
+
+    const GlobalSetters& getInsecureGlobalSetters() const
+    {
+        return m_insecureGlobalSetters;
+    }
+
 public:
     void dump(const std::string& outFile = std::string()) const;
     void dumpStats(const std::string& statsFile = std::string()) const;
@@ -78,10 +119,14 @@ private:
     llvm::Module& m_module;
     PDGType m_pdg;
     CallGraph m_callgraph;
-    const LoopInfoGetter& m_loopInfoGetter;
     Logger& m_logger;
+    std::unique_ptr<ModuleFacts> m_moduleFacts;
+    std::unique_ptr<PerformanceHints> m_hints;
+    std::unique_ptr<PreviousPartition> m_previousPartition;
     Partition m_securePartition;
     Partition m_insecurePartition;
+    GlobalSetters m_secureGlobalSetters;
+    GlobalSetters m_insecureGlobalSetters;
 }; // class ProgramPartition
 
 class ProgramPartitionAnalysis : public llvm::ModulePass
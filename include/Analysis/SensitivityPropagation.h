@@ -0,0 +1,126 @@
+#pragma once
+
+#include "Analysis/Partition.h"
+#include "Utils/Annotation.h"
+#include "Utils/RingBuffer.h"
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace llvm {
+class Function;
+}
+
+namespace pdg {
+class PDG;
+}
+
+namespace vazgen {
+
+class Logger;
+class ModuleFacts;
+class PDGSnapshot;
+
+/**
+ * \class SensitivityPropagation
+ * \brief Slices the PDG for all annotations in a single pass, propagating bitmasks of sources instead of single nodes.
+ *
+ * Each argument and return value slice of an annotation is a source with its own bit.
+ * A node is processed once per set of newly arrived sources, so regions shared by several annotations are walked once.
+ * Traversal rules are the ones of PartitionForArguments and PartitionForReturnValue in Partitioner.
+ * Call edges traversed by each source are recorded, and levels of related functions are
+ * the shortest distance over them from the annotated function, which is the fixpoint of
+ * the level updates done by the per annotation traversals.
+ */
+class SensitivityPropagation
+{
+public:
+    using PDGType = std::shared_ptr<pdg::PDG>;
+    using Annotations = std::vector<Annotation>;
+
+public:
+    SensitivityPropagation(const PDGSnapshot& pdgSnapshot,
+                           PDGType pdg,
+                           const Annotations& annotations,
+                           const ModuleFacts& moduleFacts,
+                           Logger& logger);
+
+    SensitivityPropagation(const SensitivityPropagation& ) = delete;
+    SensitivityPropagation(SensitivityPropagation&& ) = delete;
+    SensitivityPropagation& operator =(const SensitivityPropagation& ) = delete;
+    SensitivityPropagation& operator =(SensitivityPropagation&& ) = delete;
+
+public:
+    void propagate();
+
+    // Partition of annotation at the given index, same as the one the per annotation traversals compute
+    const Partition& getPartition(unsigned annotationIdx) const
+    {
+        return m_partitions[annotationIdx];
+    }
+
+    // Indices of annotations which made F a related function
+    std::vector<unsigned> getProvenance(llvm::Function* F) const;
+
+private:
+    using Word = std::uint64_t;
+    using Mask = std::vector<Word>;
+
+    struct Source
+    {
+        unsigned annotationIdx;
+        llvm::Function* function;
+        bool isReturn;
+    }; // struct Source
+
+    // State of propagation in one direction of PDG edges
+    struct Propagation
+    {
+        // Node masks, m_wordsNum words per node
+        std::vector<Word> visited;
+        std::vector<Word> pending;
+        RingBuffer<unsigned> workingList;
+        std::vector<bool> inWorkingList;
+    }; // struct Propagation
+
+    void addSources();
+    void addArgumentSeeds(unsigned source);
+    void addReturnSeeds(unsigned source);
+    void propagateForward();
+    void propagateBackward();
+    void collectStoreSeeds(unsigned node, const Mask& sources);
+    void computePartitions();
+
+    // Takes the next node with newly arrived sources. Returns false if there are none
+    bool takeNode(Propagation& propagation, unsigned& node, Mask& sources);
+    void push(Propagation& propagation, unsigned node, const Mask& sources);
+    void pushSource(Propagation& propagation, unsigned node, unsigned source);
+    void addLevelEdge(llvm::Function* from, llvm::Function* to, const Mask& sources);
+    void addRelatedFunction(llvm::Function* F, const Mask& sources);
+    // Traversals do not add the annotated function itself as related
+    Mask excludeAnnotatedBy(llvm::Function* F, const Mask& sources) const;
+
+private:
+    const PDGSnapshot& m_pdgSnapshot;
+    PDGType m_pdg;
+    const Annotations& m_annotations;
+    const ModuleFacts& m_moduleFacts;
+    const ValueIndex<llvm::Function>& m_functionIndex;
+    Logger& m_logger;
+    std::vector<Source> m_sources;
+    unsigned m_wordsNum;
+    // Sources of slices for return values
+    Mask m_returnSources;
+    Propagation m_forward;
+    Propagation m_backward;
+    // Sources which traversed call edges between two functions. Key is the pair of function ids
+    std::unordered_map<std::uint64_t, Mask> m_levelEdges;
+    // Sources which made function related, by function id
+    std::unordered_map<unsigned, Mask> m_relatedFunctions;
+    std::vector<Partition> m_partitions;
+}; // class SensitivityPropagation
+
+} // namespace vazgen
+
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace llvm {
+class Function;
+class Value;
+}
+
+namespace pdg {
+class PDG;
+}
+
+namespace vazgen {
+
+class ContextSensitiveSlicer;
+class PDGSnapshot;
+
+/**
+ * \struct SliceSummary
+ * \brief What a slicing traversal from a single PDG node reaches.
+ *
+ * Traversals stop at function nodes, so a summary only depends on its entry node.
+ * Annotation specific parts, i.e. excluding the annotated function and levels, are applied by the user.
+ */
+struct SliceSummary
+{
+    // Defined functions whose function nodes were reached
+    std::vector<llvm::Function*> reachedFunctions;
+    // Defined functions entered through pointer actual arguments
+    std::vector<llvm::Function*> calledFunctions;
+    // Pairs of different functions connected by a traversed edge, in traversal direction
+    std::vector<std::pair<llvm::Function*, llvm::Function*>> functionEdges;
+    // Value operands of reached store instructions, forward traversal only
+    std::vector<llvm::Value*> storedValues;
+}; // struct SliceSummary
+
+/// Collects a slice summary during traversal, removing duplicates
+class SliceSummaryBuilder
+{
+public:
+    std::shared_ptr<const SliceSummary> getSummary()
+    {
+        auto summary = std::make_shared<SliceSummary>();
+        summary->reachedFunctions.assign(m_reachedFunctions.begin(), m_reachedFunctions.end());
+        summary->calledFunctions.assign(m_calledFunctions.begin(), m_calledFunctions.end());
+        summary->functionEdges.assign(m_functionEdges.begin(), m_functionEdges.end());
+        summary->storedValues.assign(m_storedValues.begin(), m_storedValues.end());
+        return summary;
+    }
+
+    void addReachedFunction(llvm::Function* F)
+    {
+        m_reachedFunctions.insert(F);
+    }
+
+    void addCalledFunction(llvm::Function* F)
+    {
+        m_calledFunctions.insert(F);
+    }
+
+    void addFunctionEdge(llvm::Function* from, llvm::Function* to)
+    {
+        if (from && to && from != to) {
+            m_functionEdges.insert(std::make_pair(from, to));
+        }
+    }
+
+    void addStoredValue(llvm::Value* value)
+    {
+        m_storedValues.insert(value);
+    }
+
+private:
+    std::set<llvm::Function*> m_reachedFunctions;
+    std::set<llvm::Function*> m_calledFunctions;
+    std::set<std::pair<llvm::Function*, llvm::Function*>> m_functionEdges;
+    std::set<llvm::Value*> m_storedValues;
+}; // class SliceSummaryBuilder
+
+/**
+ * \class SliceSummaries
+ * \brief Cache of slice summaries shared by annotations of a partitioning run.
+ *
+ * Summaries are computed on first use over the PDGSnapshot, context insensitively or with ContextSensitiveSlicer.
+ * Getters may be called concurrently.
+ */
+class SliceSummaries
+{
+public:
+    using PDGType = std::shared_ptr<pdg::PDG>;
+    using SummaryType = std::shared_ptr<const SliceSummary>;
+
+    enum Direction : std::uint8_t {
+        // Forward from formal argument, as PartitionForArguments does
+        FORWARD = 0,
+        // Backward from stored value, as PartitionForArguments does
+        BACKWARD,
+        // Backward from return instruction, as PartitionForReturnValue does. Goes through nodes without values
+        RETURN_BACKWARD
+    };
+
+public:
+    SliceSummaries(PDGType pdg,
+                   const PDGSnapshot& pdgSnapshot,
+                   bool contextSensitive);
+    ~SliceSummaries();
+
+    SliceSummaries(const SliceSummaries& ) = delete;
+    SliceSummaries(SliceSummaries&& ) = delete;
+    SliceSummaries& operator =(const SliceSummaries& ) = delete;
+    SliceSummaries& operator =(SliceSummaries&& ) = delete;
+
+public:
+    const PDGSnapshot& getPDGSnapshot() const
+    {
+        return m_pdgSnapshot;
+    }
+
+    SummaryType getSummary(unsigned node, Direction direction);
+
+private:
+    SummaryType computeSummary(unsigned node, Direction direction) const;
+    SummaryType computeForwardSummary(unsigned node) const;
+    SummaryType computeBackwardSummary(unsigned node, bool throughNonValueNodes) const;
+
+    static std::uint64_t getKey(unsigned node, Direction direction)
+    {
+        return (static_cast<std::uint64_t>(node) << 2) | direction;
+    }
+
+private:
+    PDGType m_pdg;
+    const PDGSnapshot& m_pdgSnapshot;
+    std::unique_ptr<ContextSensitiveSlicer> m_contextSensitiveSlicer;
+    mutable std::shared_mutex m_mutex;
+    std::unordered_map<std::uint64_t, SummaryType> m_summaries;
+}; // class SliceSummaries
+
+} // namespace vazgen
+
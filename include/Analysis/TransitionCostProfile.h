@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+
+namespace vazgen {
+
+class Logger;
+
+/**
+ * \class TransitionCostProfile
+ * \brief Measured cost of crossing the enclave boundary, written by eval/calibration/TransitionCostBenchmark.
+ *
+ * Converts CALL_NUM and MARSHALING_BYTES edge factors to nanoseconds:
+ * every call pays the transition latency and every marshaled byte pays the copy cost.
+ */
+class TransitionCostProfile
+{
+public:
+    explicit TransitionCostProfile(Logger& logger);
+
+    TransitionCostProfile(const TransitionCostProfile& ) = delete;
+    TransitionCostProfile(TransitionCostProfile&& ) = delete;
+    TransitionCostProfile& operator =(const TransitionCostProfile& ) = delete;
+    TransitionCostProfile& operator =(TransitionCostProfile&& ) = delete;
+
+public:
+    bool load(const std::string& fileName);
+
+    const std::string& getBackend() const
+    {
+        return m_backend;
+    }
+
+    // Round trip of one ecall or ocall without parameters
+    double getTransitionNs() const
+    {
+        return m_transitionNs;
+    }
+
+    double getByteCopyNs() const
+    {
+        return m_byteCopyNs;
+    }
+
+private:
+    Logger& m_logger;
+    std::string m_backend;
+    double m_transitionNs;
+    double m_byteCopyNs;
+}; // class TransitionCostProfile
+
+} // namespace vazgen
+
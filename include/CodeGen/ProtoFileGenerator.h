@@ -3,6 +3,7 @@
 #include "CodeGen/ProtoFile.h"
 
 #include <unordered_map>
+#include <unordered_set>
 
 namespace llvm {
 class Function;
@@ -16,7 +17,13 @@ class Partition;
 class ProtoFileGenerator
 {
 public:
-    ProtoFileGenerator(const Partition& partition, const std::string& protoName);
+    using FunctionSet = std::unordered_set<llvm::Function*>;
+
+public:
+    // Additional functions, e.g. global setters, are generated along with functions of the partition
+    ProtoFileGenerator(const Partition& partition,
+                       const FunctionSet& additionalFunctions,
+                       const std::string& protoName);
 
     ProtoFileGenerator(const ProtoFileGenerator& ) = delete;
     ProtoFileGenerator(ProtoFileGenerator&& ) = delete;
@@ -40,6 +47,7 @@ private:
 
 private:
     const Partition& m_partition;
+    const FunctionSet& m_additionalFunctions;
     const std::string& m_protoName;
     ProtoFile m_protoFile;
     std::unordered_map<llvm::Type*, ProtoMessage> m_typeMessages;
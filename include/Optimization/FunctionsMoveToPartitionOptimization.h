@@ -1,30 +1,24 @@
 #pragma once
 
 #include "Optimization/PartitionOptimization.h"
-
-#include <vector>
-#include <functional>
-
-namespace llvm {
-class CallSite;
-class LoopInfo;
-}
+#include "Analysis/ModuleFacts.h"
 
 namespace vazgen {
 
 class Logger;
+class PerformanceHints;
 
 class FunctionsMoveToPartitionOptimization : public PartitionOptimization
 {
 public:
-    using CallSites = std::vector<llvm::CallSite>;
-    using LoopInfoGetter = std::function<llvm::LoopInfo* (llvm::Function*)>;
+    using CallSites = ModuleFacts::CallSiteFacts;
 
 public:
     FunctionsMoveToPartitionOptimization(Partition& partition,
                                          PDGType pdg,
-                                         Logger& logger,
-                                         const LoopInfoGetter& loopInfoGetter);
+                                         const ModuleFacts& moduleFacts,
+                                         const PerformanceHints& hints,
+                                         Logger& logger);
 
     FunctionsMoveToPartitionOptimization(const FunctionsMoveToPartitionOptimization& ) = delete;
     FunctionsMoveToPartitionOptimization(FunctionsMoveToPartitionOptimization&& ) = delete;
@@ -52,7 +46,8 @@ private:
     bool hasCallSiteInLoop(const CallSites& callSites) const;
 
 private:
-    const LoopInfoGetter& m_loopInfoGetter;
+    const ModuleFacts& m_moduleFacts;
+    const PerformanceHints& m_hints;
     Partition::FunctionSet m_movedFunctions;
 }; // class FunctionsMoveToPartitionOptimization
 
@@ -7,6 +7,9 @@ namespace vazgen {
 
 class CallGraph;
 class Logger;
+class ModuleFacts;
+class PerformanceHints;
+class PreviousPartition;
 
 class ILPOptimization : public PartitionOptimization
 {
@@ -14,6 +17,9 @@ public:
     ILPOptimization(const CallGraph& callgraph,
                     Partition& securePartition,
                     Partition& insecurePartition,
+                    const ModuleFacts& moduleFacts,
+                    const PerformanceHints& hints,
+                    const PreviousPartition& previousPartition,
                     Logger& logger);
 
     ILPOptimization(const ILPOptimization& ) = delete;
@@ -12,6 +12,7 @@ namespace vazgen {
 class CallGraph;
 class Partition;
 class Logger;
+class PreviousPartition;
 
 class KLOptimizationPass
 {
@@ -22,6 +23,7 @@ public:
     KLOptimizationPass(const CallGraph& callgraph,
                        Partition& securePartition,
                        Partition& insecurePartition,
+                       const PreviousPartition& previousPartition,
                        Logger& logger);
 
     KLOptimizationPass(const KLOptimizationPass& ) = delete;
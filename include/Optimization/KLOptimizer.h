@@ -12,6 +12,9 @@ namespace vazgen {
 
 class CallGraph;
 class Logger;
+class ModuleFacts;
+class PerformanceHints;
+class PreviousPartition;
 
 class KLOptimizer : public PartitionOptimization
 {
@@ -20,6 +23,9 @@ public:
                 PDGType pdg,
                 Partition& securePartition,
                 Partition& insecurePartition,
+                const ModuleFacts& moduleFacts,
+                const PerformanceHints& hints,
+                const PreviousPartition& previousPartition,
                 Logger& logger);
 
     KLOptimizer(const KLOptimizer& ) = delete;
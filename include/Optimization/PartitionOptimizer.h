@@ -10,15 +10,14 @@ namespace pdg {
 class PDG;
 }
 
-namespace llvm {
-class LoopInfo;
-}
-
 namespace vazgen {
 
 class PartitionOptimization;
 class Logger;
 class CallGraph;
+class ModuleFacts;
+class PerformanceHints;
+class PreviousPartition;
 
 // TODO: think about different strategies for optimization, e.g. smaller TCB, fewer function calls across partitions, etc
 class PartitionOptimizer
@@ -37,7 +36,6 @@ public:
 
     using OptimizationTy = std::shared_ptr<PartitionOptimization>;
     using PDGType = std::shared_ptr<pdg::PDG>;
-    using LoopInfoGetter = std::function<llvm::LoopInfo* (llvm::Function*)>;
     using Optimizations = std::vector<Optimization>;
 
 public:
@@ -45,6 +43,9 @@ public:
                        Partition& insecurePartition,
                        PDGType pdg,
                        const CallGraph& callGraph,
+                       const ModuleFacts& moduleFacts,
+                       const PerformanceHints& hints,
+                       const PreviousPartition& previousPartition,
                        Logger& logger);
 
     PartitionOptimizer(const PartitionOptimizer& ) = delete;
@@ -52,9 +53,6 @@ public:
     PartitionOptimizer& operator= (const PartitionOptimizer& ) = delete;
     PartitionOptimizer& operator= (PartitionOptimizer&& ) = delete;
 
-public:
-    void setLoopInfoGetter(const LoopInfoGetter& loopInfoGetter);
-
 public:
     virtual void run(const Optimizations& opts);
 
@@ -70,8 +68,12 @@ protected:
     Partition& m_insecurePartition;
     PDGType m_pdg;
     const CallGraph& m_callgraph;
+    const ModuleFacts& m_moduleFacts;
+    const PerformanceHints& m_hints;
+    const PreviousPartition& m_previousPartition;
     Logger& m_logger;
-    LoopInfoGetter m_loopInfoGetter;
+    // Secure partition before optimization, never moved out of the enclave
+    const Partition::FunctionSet m_sensitiveFunctions;
     std::vector<OptimizationTy> m_optimizations;
 }; // class PartitionOptimizer
 
@@ -26,9 +26,11 @@ public:
 
     void apply() override
     {
+        Partition::FunctionSet relatedFunctions(m_partition.getPartition().getIndex());
         for (const auto& [function, level] : m_partition.getRelatedFunctions()) {
-            m_partition.addToPartition(function);
+            relatedFunctions.insert(function);
         }
+        m_partition.addToPartition(relatedFunctions);
         m_partition.clearRelatedFunctions();
     }
 
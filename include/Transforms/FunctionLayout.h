@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vector>
+
+namespace llvm {
+class Function;
+class Module;
+}
+
+namespace vazgen {
+
+class Logger;
+class ModuleFacts;
+class Partition;
+
+/**
+ * \class FunctionLayout
+ * \brief Orders functions of an extracted module by hotness, so that hot code shares few EPC pages.
+ *
+ * Hotness of a function is the number of its entries per run, from ModuleFacts or from the -profile call counts.
+ * Hot functions, which together take most of the entries, are moved first and placed in .text.hot,
+ * functions entered at most once per run are moved last and placed in .text.unlikely.
+ * Ecalls, main and other roots are never taken as cold, as one entry per run may be a guess for them,
+ * neither are functions with no estimate at all. Functions with a section of their own keep it.
+ * Facts are looked up by name in the module the extracted one was cloned from.
+ */
+class FunctionLayout
+{
+public:
+    FunctionLayout(llvm::Module& extractedModule,
+                   llvm::Module& originalModule,
+                   const ModuleFacts& moduleFacts,
+                   const Partition& partition,
+                   Logger& logger);
+
+    FunctionLayout(const FunctionLayout& ) = delete;
+    FunctionLayout(FunctionLayout&& ) = delete;
+    FunctionLayout& operator =(const FunctionLayout& ) = delete;
+    FunctionLayout& operator =(FunctionLayout&& ) = delete;
+
+public:
+    void apply();
+
+private:
+    struct FunctionInfo
+    {
+        llvm::Function* function;
+        double entries;
+        long codeSize;
+        bool canBeCold;
+    }; // struct FunctionInfo
+
+    void collectFunctionInfos();
+    // Function of the original module entered from outside of the enclave or of the program
+    bool isEntryPoint(llvm::Function* originalF) const;
+    // Number of pages spanned by hot functions if laid out in the given order
+    unsigned getHotPagesNum(const std::vector<FunctionInfo*>& order) const;
+
+private:
+    llvm::Module& m_extractedModule;
+    llvm::Module& m_originalModule;
+    const ModuleFacts& m_moduleFacts;
+    const Partition& m_partition;
+    Logger& m_logger;
+    std::vector<FunctionInfo> m_functionInfos;
+    std::vector<bool> m_isHot;
+}; // class FunctionLayout
+
+} // namespace vazgen
+
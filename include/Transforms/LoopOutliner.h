@@ -0,0 +1,73 @@
+#pragma once
+
+#include "llvm/Pass.h"
+
+#include <vector>
+
+namespace llvm {
+class BasicBlock;
+class BlockFrequencyInfo;
+class Function;
+class Loop;
+class LoopInfo;
+}
+
+namespace vazgen {
+
+class Logger;
+class Partition;
+
+/**
+ * \class LoopOutliner
+ * \brief Outlines untrusted loops whose iterations are dominated by calls into the enclave.
+ *
+ * A loop qualifies when it calls secure partition functions on most of its iterations
+ * and those calls outweigh, by block frequency, the calls the loop would make out of the enclave.
+ * The loop nest is extracted to a new function taking the loop's live-ins and live-outs as arguments,
+ * so that placed in the enclave by the optimizer it costs one ecall per loop instead of one per iteration.
+ */
+class LoopOutliner
+{
+public:
+    using Blocks = std::vector<llvm::BasicBlock*>;
+
+public:
+    LoopOutliner(const Partition& securePartition, Logger& logger);
+
+    LoopOutliner(const LoopOutliner& ) = delete;
+    LoopOutliner(LoopOutliner&& ) = delete;
+    LoopOutliner& operator =(const LoopOutliner& ) = delete;
+    LoopOutliner& operator =(LoopOutliner&& ) = delete;
+
+public:
+    // Outermost qualifying loops of F. Loops are disjoint, so extracting one keeps the others valid
+    std::vector<Blocks> findLoops(const llvm::LoopInfo& loopInfo, const llvm::BlockFrequencyInfo& blockFrequency) const;
+    // Returns the number of outlined loops
+    unsigned outline(llvm::Function* F, const std::vector<Blocks>& loops);
+
+private:
+    void findLoops(llvm::Loop* loop, const llvm::BlockFrequencyInfo& blockFrequency, std::vector<Blocks>& loops) const;
+    bool isCrossingLoop(llvm::Loop* loop, const llvm::BlockFrequencyInfo& blockFrequency) const;
+
+private:
+    const Partition& m_securePartition;
+    Logger& m_logger;
+}; // class LoopOutliner
+
+class LoopOutlinerPass : public llvm::ModulePass
+{
+public:
+    static char ID;
+
+    LoopOutlinerPass()
+        : llvm::ModulePass(ID)
+    {
+    }
+
+public:
+    void getAnalysisUsage(llvm::AnalysisUsage& AU) const override;
+    bool runOnModule(llvm::Module& M) override;
+}; // class LoopOutlinerPass
+
+} // namespace vazgen
+
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "llvm/Pass.h"
+
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+namespace llvm {
+class BasicBlock;
+class BlockFrequencyInfo;
+class Function;
+class Instruction;
+class Module;
+class Region;
+class TargetTransformInfo;
+}
+
+namespace pdg {
+class PDG;
+}
+
+namespace vazgen {
+
+class Annotation;
+class Logger;
+class ModuleFacts;
+class PDGSnapshot;
+
+/**
+ * \class RegionOutliner
+ * \brief Outlines single entry single exit regions of an annotated function that do not touch sensitive data.
+ *
+ * Sensitive instructions of the function are those its PDG slice reaches from annotated arguments,
+ * back from values stored through them and back from returns when the return value is annotated.
+ * Maximal regions without sensitive instructions are extracted to new functions, which the partitioner
+ * then leaves outside the enclave, if the transitions added per run cost less than the enclave code removed.
+ */
+class RegionOutliner
+{
+public:
+    using PDGType = std::shared_ptr<pdg::PDG>;
+
+public:
+    RegionOutliner(llvm::Module& M,
+                   PDGType pdg,
+                   const PDGSnapshot& pdgSnapshot,
+                   const ModuleFacts& moduleFacts,
+                   Logger& logger);
+
+    RegionOutliner(const RegionOutliner& ) = delete;
+    RegionOutliner(RegionOutliner&& ) = delete;
+    RegionOutliner& operator =(const RegionOutliner& ) = delete;
+    RegionOutliner& operator =(RegionOutliner&& ) = delete;
+
+public:
+    using InstructionSet = std::unordered_set<llvm::Instruction*>;
+    using Blocks = std::vector<llvm::BasicBlock*>;
+
+    struct OutlineRegion
+    {
+        Blocks blocks;
+        // Enclave code bytes removed by outlining, net of the ocall stub
+        long savedBytes;
+    }; // struct OutlineRegion
+
+    using OutlineRegions = std::vector<OutlineRegion>;
+
+public:
+    void collectSensitiveInstructions(const Annotation& annotation, InstructionSet& sensitive) const;
+    // Regions are disjoint, so extracting one keeps the others valid
+    OutlineRegions findRegions(llvm::Function* F,
+                               const InstructionSet& sensitive,
+                               const llvm::BlockFrequencyInfo& blockFrequency,
+                               const llvm::TargetTransformInfo& targetTransformInfo) const;
+    // Returns the number of outlined regions
+    unsigned outline(llvm::Function* F, const OutlineRegions& regions);
+
+    long getSavedBytes() const
+    {
+        return m_savedBytes;
+    }
+
+private:
+    void addSlice(unsigned node, bool forward, llvm::Function* F, InstructionSet& sensitive) const;
+    void findRegions(llvm::Region* region,
+                     const std::unordered_set<llvm::BasicBlock*>& sensitiveBlocks,
+                     const llvm::BlockFrequencyInfo& blockFrequency,
+                     const llvm::TargetTransformInfo& targetTransformInfo,
+                     OutlineRegions& regions) const;
+    bool isWorthOutlining(llvm::Region* region,
+                          const llvm::BlockFrequencyInfo& blockFrequency,
+                          const llvm::TargetTransformInfo& targetTransformInfo,
+                          OutlineRegion& outlineRegion) const;
+    long getMarshaledBytes(const Blocks& blocks) const;
+
+private:
+    llvm::Module& m_module;
+    PDGType m_pdg;
+    const PDGSnapshot& m_pdgSnapshot;
+    const ModuleFacts& m_moduleFacts;
+    Logger& m_logger;
+    double m_transitionNs;
+    double m_byteCopyNs;
+    long m_savedBytes;
+}; // class RegionOutliner
+
+class RegionOutlinerPass : public llvm::ModulePass
+{
+public:
+    static char ID;
+
+    RegionOutlinerPass()
+        : llvm::ModulePass(ID)
+    {
+    }
+
+public:
+    void getAnalysisUsage(llvm::AnalysisUsage& AU) const override;
+    bool runOnModule(llvm::Module& M) override;
+}; // class RegionOutlinerPass
+
+} // namespace vazgen
+
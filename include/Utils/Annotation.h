@@ -7,15 +7,27 @@ namespace vazgen {
 /**
  * \class Annotation
  * \brief Represents security annotation for a function
+ *
+ * Performance hints are annotations too, they place functions without making them sensitive:
+ * pin-enclave and pin-untrusted fix the partition of the function, call-rate overrides the estimated number
+ * of calls to it per run and latency-critical marks calls to it, from given callers or from all, that must not
+ * cross the enclave boundary.
  */
 class Annotation
 {
+public:
+    static const std::string PIN_ENCLAVE;
+    static const std::string PIN_UNTRUSTED;
+    static const std::string CALL_RATE;
+    static const std::string LATENCY_CRITICAL;
+
 public:
     Annotation() = default;
     Annotation(const std::string& annotation, llvm::Function* F)
         : m_annotation(annotation)
         , m_F(F)
         , m_return(false)
+        , m_callRate(0)
     {
     }
 
@@ -60,6 +72,34 @@ public:
         m_return = annot;
     }
 
+    bool isPerformanceHint() const
+    {
+        return m_annotation == PIN_ENCLAVE || m_annotation == PIN_UNTRUSTED
+            || m_annotation == CALL_RATE || m_annotation == LATENCY_CRITICAL;
+    }
+
+    // Expected calls per run, for call-rate hints
+    double getCallRate() const
+    {
+        return m_callRate;
+    }
+
+    void setCallRate(double callRate)
+    {
+        m_callRate = callRate;
+    }
+
+    // Callers of latency-critical hints. Empty if all calls are critical
+    const std::vector<llvm::Function*>& getLatencyCriticalCallers() const
+    {
+        return m_latencyCriticalCallers;
+    }
+
+    void addLatencyCriticalCaller(llvm::Function* caller)
+    {
+        m_latencyCriticalCallers.push_back(caller);
+    }
+
     bool operator ==(const Annotation& annot) const
     {
         return m_F == annot.getFunction() && m_annotation == annot.getAnnotation();
@@ -73,6 +113,8 @@ private:
     llvm::Function* m_F;
     std::vector<unsigned> m_arguments;
     bool m_return;
+    double m_callRate;
+    std::vector<llvm::Function*> m_latencyCriticalCallers;
 }; // class Annotation
 
 } // namespace vazgen
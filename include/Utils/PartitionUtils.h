@@ -1,6 +1,11 @@
 #pragma once
 
-#include <unordered_set>
+#include "Analysis/Partition.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
 
 namespace pdg {
 class PDG;
@@ -12,14 +17,83 @@ class Function;
 
 namespace vazgen {
 
+class Logger;
+class ModuleFacts;
+
 class PartitionUtils
 {
 public:
-    using FunctionSet = std::unordered_set<llvm::Function*>;
+    using FunctionSet = Partition::FunctionSet;
     static  FunctionSet computeInInterface(const FunctionSet& functions,
                                            const pdg::PDG& pdg);
     static  FunctionSet computeOutInterface(const FunctionSet& functions,
                                             const pdg::PDG& pdg);
+
+    // Collects the call edges both interface computations above follow, so partitions can maintain interfaces incrementally
+    static Partition::InterfaceGraphType computeInterfaceGraph(const pdg::PDG& pdg,
+                                                               const ModuleFacts& moduleFacts);
+    // Debug check comparing incrementally maintained interfaces with recomputed ones. Runs with -verify-partition-interfaces
+    static bool verifyInterfaces(const Partition& partition,
+                                 const pdg::PDG& pdg,
+                                 Logger& logger);
+
+    // Minimal number of globals worth a separate thread, for tasks scanning the uses or PDG edges of each global
+    static const unsigned GLOBALS_SHARD_SIZE = 256;
+
+    // Number of worker threads partitioning analyses may use. Set with -partition-threads, defaults to hardware concurrency
+    static unsigned getThreadsNum();
+
+    // Splits [0, size) into contiguous shards and runs shardF(begin, end, shardIdx) on each of them in its own thread.
+    // Returns the number of shards. Ranges smaller than two shards are processed in the calling thread.
+    template <typename ShardFunction>
+    static unsigned parallelFor(unsigned size, unsigned minShardSize, const ShardFunction& shardF)
+    {
+        const unsigned shardsNum = std::max(1u, std::min(getThreadsNum(), size / std::max(1u, minShardSize)));
+        if (shardsNum == 1) {
+            shardF(0u, size, 0u);
+            return 1;
+        }
+        const unsigned shardSize = (size + shardsNum - 1) / shardsNum;
+        std::vector<std::thread> threads;
+        threads.reserve(shardsNum);
+        for (unsigned shard = 0; shard < shardsNum; ++shard) {
+            const unsigned begin = std::min(size, shard * shardSize);
+            const unsigned end = std::min(size, begin + shardSize);
+            threads.emplace_back([&shardF, begin, end, shard] () { shardF(begin, end, shard); });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        return shardsNum;
+    }
+
+    // Runs taskF(taskIdx, workerIdx) for every task in [0, size) on a pool of worker threads.
+    // Idle workers take the next pending task, so a few expensive tasks do not stall a whole shard.
+    // Returns the number of workers; tasks of a worker run sequentially.
+    template <typename TaskFunction>
+    static unsigned parallelForEach(unsigned size, const TaskFunction& taskF)
+    {
+        const unsigned workersNum = std::max(1u, std::min(getThreadsNum(), size));
+        std::atomic<unsigned> nextTask(0);
+        auto worker = [&taskF, &nextTask, size] (unsigned workerIdx) {
+            for (unsigned task = nextTask++; task < size; task = nextTask++) {
+                taskF(task, workerIdx);
+            }
+        };
+        if (workersNum == 1) {
+            worker(0u);
+            return 1;
+        }
+        std::vector<std::thread> threads;
+        threads.reserve(workersNum);
+        for (unsigned workerIdx = 0; workerIdx < workersNum; ++workerIdx) {
+            threads.emplace_back(worker, workerIdx);
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        return workersNum;
+    }
 }; // class PartitionUtils
 
 } // namespace vazgen
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace vazgen {
+
+/**
+ * \class RingBuffer
+ * \brief FIFO queue over a contiguous power of two sized buffer. Grows when full.
+ */
+template <typename T>
+class RingBuffer
+{
+public:
+    explicit RingBuffer(std::size_t capacity = 64)
+        : m_buffer(getCapacity(capacity))
+        , m_head(0)
+        , m_size(0)
+    {
+    }
+
+public:
+    void push(const T& value)
+    {
+        if (m_size == m_buffer.size()) {
+            grow();
+        }
+        m_buffer[(m_head + m_size) & (m_buffer.size() - 1)] = value;
+        ++m_size;
+    }
+
+    T pop()
+    {
+        T value = m_buffer[m_head];
+        m_head = (m_head + 1) & (m_buffer.size() - 1);
+        --m_size;
+        return value;
+    }
+
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    std::size_t size() const
+    {
+        return m_size;
+    }
+
+    void clear()
+    {
+        m_head = 0;
+        m_size = 0;
+    }
+
+private:
+    static std::size_t getCapacity(std::size_t capacity)
+    {
+        std::size_t powerOfTwo = 1;
+        while (powerOfTwo < capacity) {
+            powerOfTwo <<= 1;
+        }
+        return powerOfTwo;
+    }
+
+    void grow()
+    {
+        std::vector<T> buffer(m_buffer.size() * 2);
+        for (std::size_t i = 0; i < m_size; ++i) {
+            buffer[i] = m_buffer[(m_head + i) & (m_buffer.size() - 1)];
+        }
+        m_buffer.swap(buffer);
+        m_head = 0;
+    }
+
+private:
+    std::vector<T> m_buffer;
+    std::size_t m_head;
+    std::size_t m_size;
+}; // class RingBuffer
+
+} // namespace vazgen
+
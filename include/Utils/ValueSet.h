@@ -0,0 +1,352 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <unordered_map>
+#include <vector>
+
+namespace vazgen {
+
+/**
+ * \class ValueIndex
+ * \brief Dense ids of values of type T, assigned once for the values of a module.
+ *
+ * Ids follow the order values are given at construction and never change. The index is immutable,
+ * so concurrent lookups need no locking. ModuleFacts owns the indices of the module's functions and globals.
+ */
+template <typename T>
+class ValueIndex
+{
+public:
+    static constexpr unsigned INVALID_ID = ~0u;
+
+public:
+    template <typename Iterator>
+    ValueIndex(Iterator begin, Iterator end)
+    {
+        for (auto it = begin; it != end; ++it) {
+            T* value = &*it;
+            if (m_ids.insert(std::make_pair(value, m_values.size())).second) {
+                m_values.push_back(value);
+            }
+        }
+    }
+
+    ValueIndex(const ValueIndex& ) = delete;
+    ValueIndex(ValueIndex&& ) = delete;
+    ValueIndex& operator =(const ValueIndex& ) = delete;
+    ValueIndex& operator =(ValueIndex&& ) = delete;
+
+public:
+    // INVALID_ID for values not in the index
+    unsigned getId(const T* value) const
+    {
+        auto pos = m_ids.find(value);
+        return pos == m_ids.end() ? INVALID_ID : pos->second;
+    }
+
+    T* getValue(unsigned id) const
+    {
+        return m_values[id];
+    }
+
+    unsigned size() const
+    {
+        return m_values.size();
+    }
+
+private:
+    std::unordered_map<const T*, unsigned> m_ids;
+    std::vector<T*> m_values;
+}; // class ValueIndex
+
+/**
+ * \class ValueSet
+ * \brief Dense bitset over ValueIndex ids.
+ *
+ * Membership is a single bit test, union, intersection and difference are done a word at a time.
+ * Iteration visits values in the order of the index.
+ * A default constructed set has no index and is empty until it takes one by assignment or union
+ * with a set that has it. Values can be inserted only into sets that have an index.
+ */
+template <typename T>
+class ValueSet
+{
+public:
+    using Word = std::uint64_t;
+    static constexpr unsigned WORD_BITS = 64;
+
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T*;
+        using difference_type = std::ptrdiff_t;
+        using pointer = T* const*;
+        using reference = T*;
+
+    public:
+        const_iterator(const ValueSet* set, unsigned id)
+            : m_set(set)
+            , m_id(id)
+        {
+        }
+
+        T* operator *() const
+        {
+            return m_set->m_index->getValue(m_id);
+        }
+
+        const_iterator& operator ++()
+        {
+            m_id = m_set->nextId(m_id + 1);
+            return *this;
+        }
+
+        const_iterator operator ++(int )
+        {
+            const_iterator tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+
+        bool operator ==(const const_iterator& it) const
+        {
+            return m_id == it.m_id;
+        }
+
+        bool operator !=(const const_iterator& it) const
+        {
+            return m_id != it.m_id;
+        }
+
+        unsigned getId() const
+        {
+            return m_id;
+        }
+
+    private:
+        const ValueSet* m_set;
+        unsigned m_id;
+    }; // class const_iterator
+
+    using iterator = const_iterator;
+
+public:
+    ValueSet() = default;
+
+    explicit ValueSet(const ValueIndex<T>* index)
+        : m_index(index)
+    {
+    }
+
+    template <typename Iterator>
+    ValueSet(const ValueIndex<T>* index, Iterator begin, Iterator end)
+        : m_index(index)
+    {
+        insert(begin, end);
+    }
+
+public:
+    const ValueIndex<T>* getIndex() const
+    {
+        return m_index;
+    }
+
+    unsigned getId(const T* value) const
+    {
+        return m_index ? m_index->getId(value) : ValueIndex<T>::INVALID_ID;
+    }
+
+    // Values missing from the index are not inserted
+    bool insert(T* value)
+    {
+        assert(m_index && "Inserting into a value set without index");
+        const unsigned id = m_index->getId(value);
+        return id != ValueIndex<T>::INVALID_ID && insertId(id);
+    }
+
+    template <typename Iterator>
+    void insert(Iterator begin, Iterator end)
+    {
+        for (auto it = begin; it != end; ++it) {
+            insert(*it);
+        }
+    }
+
+    bool insertId(unsigned id)
+    {
+        const unsigned word = id / WORD_BITS;
+        if (word >= m_words.size()) {
+            m_words.resize(word + 1, 0);
+        }
+        const Word mask = Word(1) << (id % WORD_BITS);
+        const bool inserted = !(m_words[word] & mask);
+        m_words[word] |= mask;
+        return inserted;
+    }
+
+    std::size_t erase(T* value)
+    {
+        return eraseId(getId(value));
+    }
+
+    std::size_t eraseId(unsigned id)
+    {
+        if (!containsId(id)) {
+            return 0;
+        }
+        m_words[id / WORD_BITS] &= ~(Word(1) << (id % WORD_BITS));
+        return 1;
+    }
+
+    void clear()
+    {
+        m_words.clear();
+    }
+
+    bool contains(T* value) const
+    {
+        return containsId(getId(value));
+    }
+
+    bool containsId(unsigned id) const
+    {
+        const unsigned word = id / WORD_BITS;
+        if (id == ValueIndex<T>::INVALID_ID || word >= m_words.size()) {
+            return false;
+        }
+        return m_words[word] & (Word(1) << (id % WORD_BITS));
+    }
+
+    std::size_t count(T* value) const
+    {
+        return contains(value) ? 1 : 0;
+    }
+
+    const_iterator find(T* value) const
+    {
+        const unsigned id = getId(value);
+        return containsId(id) ? const_iterator(this, id) : end();
+    }
+
+    std::size_t size() const
+    {
+        std::size_t size = 0;
+        for (auto word : m_words) {
+            size += __builtin_popcountll(word);
+        }
+        return size;
+    }
+
+    bool empty() const
+    {
+        for (auto word : m_words) {
+            if (word) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool intersects(const ValueSet& set) const
+    {
+        const auto words = std::min(m_words.size(), set.m_words.size());
+        for (std::size_t i = 0; i < words; ++i) {
+            if (m_words[i] & set.m_words[i]) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+public:
+    ValueSet& operator |=(const ValueSet& set)
+    {
+        if (!m_index) {
+            m_index = set.m_index;
+        }
+        if (set.m_words.size() > m_words.size()) {
+            m_words.resize(set.m_words.size(), 0);
+        }
+        for (std::size_t i = 0; i < set.m_words.size(); ++i) {
+            m_words[i] |= set.m_words[i];
+        }
+        return *this;
+    }
+
+    ValueSet& operator &=(const ValueSet& set)
+    {
+        if (m_words.size() > set.m_words.size()) {
+            m_words.resize(set.m_words.size());
+        }
+        for (std::size_t i = 0; i < m_words.size(); ++i) {
+            m_words[i] &= set.m_words[i];
+        }
+        return *this;
+    }
+
+    ValueSet& operator -=(const ValueSet& set)
+    {
+        const auto words = std::min(m_words.size(), set.m_words.size());
+        for (std::size_t i = 0; i < words; ++i) {
+            m_words[i] &= ~set.m_words[i];
+        }
+        return *this;
+    }
+
+    bool operator ==(const ValueSet& set) const
+    {
+        const auto& shorter = m_words.size() < set.m_words.size() ? m_words : set.m_words;
+        const auto& longer = m_words.size() < set.m_words.size() ? set.m_words : m_words;
+        for (std::size_t i = 0; i < longer.size(); ++i) {
+            const Word word = i < shorter.size() ? shorter[i] : 0;
+            if (word != longer[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool operator !=(const ValueSet& set) const
+    {
+        return !(*this == set);
+    }
+
+public:
+    const_iterator begin() const
+    {
+        return const_iterator(this, nextId(0));
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator(this, ValueIndex<T>::INVALID_ID);
+    }
+
+private:
+    unsigned nextId(unsigned id) const
+    {
+        unsigned word = id / WORD_BITS;
+        if (word >= m_words.size()) {
+            return ValueIndex<T>::INVALID_ID;
+        }
+        Word bits = m_words[word] & (~Word(0) << (id % WORD_BITS));
+        while (!bits) {
+            if (++word == m_words.size()) {
+                return ValueIndex<T>::INVALID_ID;
+            }
+            bits = m_words[word];
+        }
+        return word * WORD_BITS + __builtin_ctzll(bits);
+    }
+
+private:
+    const ValueIndex<T>* m_index = nullptr;
+    std::vector<Word> m_words;
+}; // class ValueSet
+
+} // namespace vazgen
+
@@ -1,10 +1,12 @@
 #include "Analysis/CallGraph.h"
 
+#include "Analysis/CallProfile.h"
+#include "Analysis/ModuleFacts.h"
+#include "Analysis/LibraryCalls.h"
+#include "Analysis/PerformanceHints.h"
+#include "Analysis/TransitionCostProfile.h"
 #include "Analysis/ProgramPartitionAnalysis.h"
 #include "Utils/Logger.h"
-#include "Utils/Utils.h"
-#include "PDG/PDG/PDG.h"
-#include "PDG/PDG/FunctionPDG.h"
 #include "PDG/Passes/PDGBuildPasses.h"
 
 #include "llvm/Analysis/CallGraph.h"
@@ -14,11 +16,29 @@
 #include "llvm/IR/Type.h"
 #include "llvm/PassRegistry.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Transforms/IPO/PassManagerBuilder.h"
 #include "llvm/Analysis/DOTGraphTraitsPass.h"
 
+#include <algorithm>
 #include <sstream>
 
+llvm::cl::opt<std::string> Profile(
+    "profile",
+    llvm::cl::desc("Shadow call stack file with measured caller/callee call counts"),
+    llvm::cl::value_desc("profile file"));
+
+llvm::cl::opt<double> ProfileWeight(
+    "profile-weight",
+    llvm::cl::desc("Share of measured call counts in call weights, the rest is the static estimate. Defaults to 1"),
+    llvm::cl::value_desc("weight between 0 and 1"),
+    llvm::cl::init(1.0));
+
+llvm::cl::opt<std::string> CostProfile(
+    "cost-profile",
+    llvm::cl::desc("Transition cost profile, converts context switch and marshaling weights to nanoseconds"),
+    llvm::cl::value_desc("cost profile file"));
+
 namespace llvm {
 
 template <> struct GraphTraits<vazgen::Node*>
@@ -186,76 +206,6 @@ static const int LOOP_COST = 1000;
 
 namespace {
 
-using CallSiteInfo = std::unordered_map<llvm::Function*, bool>;
-// For each function functions it is calling with being in loop information
-using FunctionCallSiteInfo = std::unordered_map<llvm::Function*, CallSiteInfo>;
-
-FunctionCallSiteInfo
-getFunctionsCallSiteInfo(const pdg::PDG* pdg, const CallGraph::LoopInfoGetter& loopInfoGetter)
-{
-    FunctionCallSiteInfo functionsCallSiteInfo;
-    for (auto& node : pdg->getFunctionPDGs()) {
-        llvm::Function* callee = node.first;
-        for (auto& callSite : node.second->getCallSites()) {
-            llvm::Function* caller = callSite.getCaller();
-            auto* loopInfo = loopInfoGetter(caller);
-            auto* callerBlock = callSite.getParent();
-            const bool isCallSiteInLoop = (loopInfo->getLoopFor(callerBlock) != nullptr);
-            functionsCallSiteInfo[caller].insert(std::make_pair(callee, isCallSiteInLoop));
-        }
-    }
-    return functionsCallSiteInfo;
-}
-
-std::unordered_map<const llvm::CallSite*, bool>
-getCallSiteLoopInformation(const pdg::PDG* pdg,
-                           const CallGraph::LoopInfoGetter& loopInfoGetter)
-{
-    std::unordered_map<const llvm::CallSite*, bool> callSiteInLoop;
-    for (auto& node : pdg->getFunctionPDGs()) {
-        auto Fpdg = node.second;
-        const auto& callSites = Fpdg->getCallSites();
-        for (auto& callSite : callSites) {
-            llvm::Function* caller = callSite.getCaller();
-            auto* loopInfo = loopInfoGetter(caller);
-            auto* callerBlock = callSite.getParent();
-            callSiteInLoop[&callSite]
-                = (loopInfo->getLoopFor(callerBlock) != nullptr);
-        }
-    }
-    return callSiteInLoop;
-}
-
-int getTypeComplexity(llvm::Type* type)
-{
-    int complexity = 0;
-    if (auto* structType = llvm::dyn_cast<llvm::StructType>(type)) {
-        for (auto it = structType->element_begin(); it != structType->element_end(); ++it) {
-            complexity += getTypeComplexity(*it);
-        }
-    } else if (auto* arrayType = llvm::dyn_cast<llvm::ArrayType>(type)) {
-        complexity += arrayType->getNumElements() * getTypeComplexity(arrayType->getElementType());
-    } else if (auto* vectorType = llvm::dyn_cast<llvm::VectorType>(type)) {
-        complexity += vectorType->getNumElements() * getTypeComplexity(vectorType->getElementType());
-    } else if (auto* ptrType = llvm::dyn_cast<llvm::PointerType>(type)) {
-        // TODO: think about the cost for this
-    } else if (auto* functionType = llvm::dyn_cast<llvm::FunctionType>(type)) {
-        // TODO: think about the cost for this, probably should be very high
-    } else {
-        complexity += 1;
-    }
-    return complexity;
-}
-
-int getArgComplexity(llvm::Function* F)
-{
-    int complexity = 0;
-    for (auto it = F->arg_begin(); it != F->arg_end(); ++it) {
-        complexity += getTypeComplexity(it->getType());
-    }
-    return complexity;
-}
-
 std::string getNodeFactorName(WeightFactor::Factor fact)
 {
     switch (fact) {
@@ -265,6 +215,8 @@ std::string getNodeFactorName(WeightFactor::Factor fact)
         return "sensitive_related";
     case WeightFactor::SIZE:
         return "size";
+    case WeightFactor::MEMORY_INTENSITY:
+        return "memory_intensity";
     case WeightFactor::CALL_NUM:
         return "in_loop";
     case WeightFactor::ARG_NUM:
@@ -273,6 +225,8 @@ std::string getNodeFactorName(WeightFactor::Factor fact)
         return "arg_complexity";
     case WeightFactor::RET_COMPLEXITY:
         return "ret_complexity";
+    case WeightFactor::MARSHALING_BYTES:
+        return "marshaling_bytes";
     default:
         assert(false);
     };
@@ -283,15 +237,14 @@ std::string getNodeFactorName(WeightFactor::Factor fact)
 class WeightAssigningHelper
 {
 public:
-    using LoopInfoGetter = CallGraph::LoopInfoGetter;
     using CallSiteData = std::unordered_map<llvm::Function*, std::unordered_map<llvm::Function*, Double>>;
 
 public:
     WeightAssigningHelper(CallGraph& callGraph,
                           const Partition& securePartition,
                           const Partition& insecurePartition,
-                          const pdg::PDG* pdg,
-                          const LoopInfoGetter& loopInfoGetter,
+                          const ModuleFacts& moduleFacts,
+                          const PerformanceHints& hints,
                           Logger& logger);
     
     void assignWeights();
@@ -301,11 +254,18 @@ private:
     void assignSensitiveNodeWeights();
     void assignSensitiveRelatedNodeWeights();
     void assignNodeSizeWeights();
+    void assignMemoryIntensityWeights();
     void assignEdgeWeights();
     void assignCallNumWeights();
     void assignArgWeights();
     void assignRetValueWeights();
+    void assignMarshalingWeights();
+    void assignLibraryCallWeights();
+    void applyTransitionCosts();
     CallSiteData collectFunctionCallSiteData();
+    void applyCallProfile(CallSiteData& callSiteData);
+    void applyCallRates(CallSiteData& callSiteData);
+    void applyLatencyCriticalCalls(CallSiteData& callSiteData);
     void normalizeWeights();
     void normalizeWeights(const std::vector<Double*>& weights);
 
@@ -313,31 +273,41 @@ private:
     CallGraph& m_callGraph;
     const Partition& m_securePartition;
     const Partition& m_insecurePartition;
-    const pdg::PDG* m_pdg;
-    const LoopInfoGetter& m_loopInfoGetter;
+    const ModuleFacts& m_moduleFacts;
+    const PerformanceHints& m_hints;
     Logger& m_logger;
+    std::unique_ptr<CallProfile> m_callProfile;
     std::unordered_map<WeightFactor::Factor, std::vector<Double*>> m_factorWeights;
 }; // class WeightAssigningHelper
 
 WeightAssigningHelper::WeightAssigningHelper(CallGraph& callGraph,
                                              const Partition& securePartition,
                                              const Partition& insecurePartition,
-                                             const pdg::PDG* pdg,
-                                             const LoopInfoGetter& loopInfoGetter,
+                                             const ModuleFacts& moduleFacts,
+                                             const PerformanceHints& hints,
                                              Logger& logger)
     : m_callGraph(callGraph)
     , m_securePartition(securePartition)
     , m_insecurePartition(insecurePartition)
-    , m_pdg(pdg)
-    , m_loopInfoGetter(loopInfoGetter)
+    , m_moduleFacts(moduleFacts)
+    , m_hints(hints)
     , m_logger(logger)
 {
+    if (!Profile.empty()) {
+        m_callProfile = std::make_unique<CallProfile>(m_logger);
+        if (!m_callProfile->load(Profile) || m_callProfile->empty()) {
+            m_callProfile.reset();
+        }
+    }
 }
  
 void WeightAssigningHelper::assignWeights()
 {
     assignNodeWeights();
     assignEdgeWeights();
+    if (!CostProfile.empty()) {
+        applyTransitionCosts();
+    }
     normalizeWeights();
 }
 
@@ -346,6 +316,7 @@ void WeightAssigningHelper::assignNodeWeights()
     assignSensitiveNodeWeights();
     assignSensitiveRelatedNodeWeights();
     assignNodeSizeWeights();
+    assignMemoryIntensityWeights();
 }
 
 void WeightAssigningHelper::assignSensitiveNodeWeights()
@@ -386,26 +357,53 @@ void WeightAssigningHelper::assignNodeSizeWeights()
     for (auto it = m_callGraph.begin();
             it != m_callGraph.end();
             ++it) {
-        int Fsize = Utils::getFunctionSize(it->first);
-        sizeFactor.setValue(Fsize);
+        sizeFactor.setValue(m_moduleFacts.getCodeSize(it->first));
         Weight& nodeWeight = it->second->getWeight();
         nodeWeight.addFactor(sizeFactor);
         m_factorWeights[WeightFactor::SIZE].push_back(&nodeWeight.getFactor(WeightFactor::SIZE).getValue());
     }
 }
 
+void WeightAssigningHelper::assignMemoryIntensityWeights()
+{
+    m_logger.info("Compute in-enclave memory penalty weights for nodes");
+    WeightFactor factor(WeightFactor::MEMORY_INTENSITY);
+    for (auto it = m_callGraph.begin(); it != m_callGraph.end(); ++it) {
+        llvm::Function* F = it->first;
+        double entries = m_moduleFacts.getFunctionFrequency(F);
+        if (m_callProfile && m_callProfile->hasFunction(F)) {
+            entries = m_callProfile->getEntriesNum(F);
+        }
+        // Memory encryption and EPC misses slow down each executed memory operation, so the penalty is
+        // the absolute number of operations per run. Their share in executed instructions would rank
+        // a rarely called accessor above a hot loop
+        factor.setValue(m_moduleFacts.getMemoryOperations(F) * entries);
+        Weight& nodeWeight = it->second->getWeight();
+        nodeWeight.addFactor(factor);
+        m_factorWeights[WeightFactor::MEMORY_INTENSITY].push_back(&nodeWeight.getFactor(WeightFactor::MEMORY_INTENSITY).getValue());
+    }
+}
+
 void WeightAssigningHelper::assignEdgeWeights()
 {
     // TODO: for each make sure to assign both to in edges and out edges
     assignCallNumWeights();
     assignArgWeights();
     assignRetValueWeights();
+    assignMarshalingWeights();
+    assignLibraryCallWeights();
 }
 
 void WeightAssigningHelper::assignCallNumWeights()
 {
     m_logger.info("Compute context switch weights for edges");
-    const auto& callSiteData = collectFunctionCallSiteData();
+    auto callSiteData = collectFunctionCallSiteData();
+    if (m_callProfile) {
+        applyCallProfile(callSiteData);
+    }
+    // User hints override both static estimates and profiles
+    applyCallRates(callSiteData);
+    applyLatencyCriticalCalls(callSiteData);
     WeightFactor callNumFactor(WeightFactor::CALL_NUM);
     for (auto it = m_callGraph.begin(); it != m_callGraph.end(); ++it) {
         llvm::Function* F = it->first;
@@ -417,7 +415,7 @@ void WeightAssigningHelper::assignCallNumWeights()
              edge_it != it->second->inEdgesEnd();
              ++edge_it) {
              llvm::Function* caller = edge_it->getSource()->getFunction();
-             int calls = functionCallDataPos->second.find(caller)->second;
+             double calls = functionCallDataPos->second.find(caller)->second;
              Weight& edgeWeight = edge_it->getWeight();
              callNumFactor.setValue(calls);
              edgeWeight.addFactor(callNumFactor);
@@ -441,7 +439,7 @@ void WeightAssigningHelper::assignCallNumWeights()
             if (callerPos == functionCallDataPos->second.end()) {
                 continue;
             }
-            int calls = callerPos->second;
+            double calls = callerPos->second;
             Weight& edgeWeight = edge_it->getWeight();
             callNumFactor.setValue(calls);
             edgeWeight.addFactor(callNumFactor);
@@ -456,7 +454,7 @@ void WeightAssigningHelper::assignArgWeights()
     WeightFactor argComplexityFactor(WeightFactor::ARG_COMPLEXITY);
     for (auto it = m_callGraph.begin(); it != m_callGraph.end(); ++it) {
         argNumFactor.setValue(it->first->arg_size());
-        int argsComplexity = getArgComplexity(it->first);
+        int argsComplexity = m_moduleFacts.getArgComplexity(it->first);
         argComplexityFactor.setValue(argsComplexity);
         for (auto edge_it = it->second->inEdgesBegin();
              edge_it != it->second->inEdgesEnd();
@@ -475,7 +473,7 @@ void WeightAssigningHelper::assignRetValueWeights()
     m_logger.info("Compute return value weights for edges");
     WeightFactor factor(WeightFactor::RET_COMPLEXITY);
     for (auto it = m_callGraph.begin(); it != m_callGraph.end(); ++it) {
-        factor.setValue(getTypeComplexity(it->first->getReturnType()));
+        factor.setValue(m_moduleFacts.getReturnComplexity(it->first));
         for (auto edge_it = it->second->inEdgesBegin();
                 edge_it != it->second->inEdgesEnd();
                 ++edge_it) {
@@ -486,26 +484,234 @@ void WeightAssigningHelper::assignRetValueWeights()
     }
 }
 
+void WeightAssigningHelper::assignMarshalingWeights()
+{
+    m_logger.info("Compute marshaled bytes weights for edges");
+    WeightFactor factor(WeightFactor::MARSHALING_BYTES);
+    for (auto it = m_callGraph.begin(); it != m_callGraph.end(); ++it) {
+        factor.setValue(m_moduleFacts.getArgBytes(it->first) + m_moduleFacts.getReturnBytes(it->first));
+        for (auto edge_it = it->second->inEdgesBegin();
+                edge_it != it->second->inEdgesEnd();
+                ++edge_it) {
+            Weight& edgeWeight = edge_it->getWeight();
+            edgeWeight.addFactor(factor);
+            m_factorWeights[WeightFactor::MARSHALING_BYTES].push_back(&edgeWeight.getFactor(WeightFactor::MARSHALING_BYTES).getValue());
+        }
+    }
+}
+
+void WeightAssigningHelper::assignLibraryCallWeights()
+{
+    // Enclave safe library functions are called in place from both partitions, their calls never cross
+    const auto& clearEdgeWeight = [] (Weight& edgeWeight) {
+        for (auto factor : {WeightFactor::CALL_NUM, WeightFactor::ARG_NUM, WeightFactor::ARG_COMPLEXITY,
+                            WeightFactor::RET_COMPLEXITY, WeightFactor::MARSHALING_BYTES}) {
+            if (edgeWeight.hasFactor(factor)) {
+                edgeWeight.getFactor(factor).setValue(0);
+            }
+        }
+    };
+    const auto& libraryCalls = LibraryCalls::get();
+    unsigned secureCallsNum = 0;
+    for (auto it = m_callGraph.begin(); it != m_callGraph.end(); ++it) {
+        if (libraryCalls.isEnclaveSafe(it->first)) {
+            for (auto edge_it = it->second->inEdgesBegin(); edge_it != it->second->inEdgesEnd(); ++edge_it) {
+                clearEdgeWeight(edge_it->getWeight());
+                if (m_securePartition.contains(edge_it->getSource()->getFunction())) {
+                    ++secureCallsNum;
+                }
+            }
+        }
+        for (auto edge_it = it->second->outEdgesBegin(); edge_it != it->second->outEdgesEnd(); ++edge_it) {
+            if (libraryCalls.isEnclaveSafe(edge_it->getSink()->getFunction())) {
+                clearEdgeWeight(edge_it->getWeight());
+            }
+        }
+    }
+    m_logger.info(std::to_string(secureCallsNum)
+                  + " call edges from secure partition to enclave safe library functions are called in place");
+}
+
+void WeightAssigningHelper::applyTransitionCosts()
+{
+    TransitionCostProfile costProfile(m_logger);
+    if (!costProfile.load(CostProfile)) {
+        return;
+    }
+    const auto& applyCosts = [&costProfile] (Weight& edgeWeight) {
+        if (!edgeWeight.hasFactor(WeightFactor::CALL_NUM)) {
+            return;
+        }
+        auto& callNumFactor = edgeWeight.getFactor(WeightFactor::CALL_NUM);
+        callNumFactor.setCoef(costProfile.getTransitionNs());
+        if (edgeWeight.hasFactor(WeightFactor::MARSHALING_BYTES)) {
+            // Bytes per call become bytes per run
+            auto& bytesFactor = edgeWeight.getFactor(WeightFactor::MARSHALING_BYTES);
+            bytesFactor.setValue(bytesFactor.getValue() * callNumFactor.getValue());
+            bytesFactor.setCoef(costProfile.getByteCopyNs());
+        }
+    };
+    const auto& getCostNs = [] (const Weight& edgeWeight) {
+        double cost = 0;
+        for (auto factor : {WeightFactor::CALL_NUM, WeightFactor::MARSHALING_BYTES}) {
+            if (edgeWeight.hasFactor(factor)) {
+                cost += edgeWeight.getFactor(factor).getWeight();
+            }
+        }
+        return cost;
+    };
+    double boundaryCost = 0;
+    double maxEdgeCost = 0;
+    for (auto it = m_callGraph.begin(); it != m_callGraph.end(); ++it) {
+        const bool isSecure = m_securePartition.contains(it->first);
+        for (auto edge_it = it->second->inEdgesBegin(); edge_it != it->second->inEdgesEnd(); ++edge_it) {
+            Weight& edgeWeight = edge_it->getWeight();
+            applyCosts(edgeWeight);
+            const double edgeCost = getCostNs(edgeWeight);
+            maxEdgeCost = std::max(maxEdgeCost, edgeCost);
+            if (isSecure != m_securePartition.contains(edge_it->getSource()->getFunction())) {
+                boundaryCost += edgeCost;
+            }
+        }
+        for (auto edge_it = it->second->outEdgesBegin(); edge_it != it->second->outEdgesEnd(); ++edge_it) {
+            applyCosts(edge_it->getWeight());
+        }
+    }
+    m_logger.info("Estimated cost of boundary crossings of secure partition: "
+                  + std::to_string(boundaryCost / 1000000) + "ms per run");
+    // Node factors are normalized to [0, 1], so are transition costs. Both factors are divided by the cost
+    // of the most expensive edge, instead of being normalized apart, to keep their ratio given by the profile
+    const auto& scaleCosts = [maxEdgeCost] (Weight& edgeWeight) {
+        for (auto factor : {WeightFactor::CALL_NUM, WeightFactor::MARSHALING_BYTES}) {
+            if (edgeWeight.hasFactor(factor)) {
+                auto& weightFactor = edgeWeight.getFactor(factor);
+                weightFactor.setValue(weightFactor.getValue().getValue() / maxEdgeCost);
+            }
+        }
+    };
+    if (maxEdgeCost > 0) {
+        for (auto it = m_callGraph.begin(); it != m_callGraph.end(); ++it) {
+            for (auto edge_it = it->second->inEdgesBegin(); edge_it != it->second->inEdgesEnd(); ++edge_it) {
+                scaleCosts(edge_it->getWeight());
+            }
+            for (auto edge_it = it->second->outEdgesBegin(); edge_it != it->second->outEdgesEnd(); ++edge_it) {
+                scaleCosts(edge_it->getWeight());
+            }
+        }
+    }
+    m_factorWeights.erase(WeightFactor::CALL_NUM);
+    m_factorWeights.erase(WeightFactor::MARSHALING_BYTES);
+}
+
 WeightAssigningHelper::CallSiteData
 WeightAssigningHelper::collectFunctionCallSiteData()
 {
     CallSiteData callSiteData;
-    for (auto& Fpdg : m_pdg->getFunctionPDGs()) {
-        auto& fCallSiteData = callSiteData[Fpdg.first];
-        for (const auto& callSite : Fpdg.second->getCallSites()) {
-            llvm::Function* caller = callSite.getCaller();
-            llvm::LoopInfo* loop = m_loopInfoGetter(caller);
-            if (loop && loop->getLoopFor(callSite.getParent())) {
-                //fCallSiteData[caller] = Double::POS_INFINITY;
-                fCallSiteData[caller] = LOOP_COST;
-            } else if (!fCallSiteData[caller].isPosInfinity()) {
-                ++fCallSiteData[caller];
+    for (auto it = m_callGraph.begin(); it != m_callGraph.end(); ++it) {
+        const auto& callSites = m_moduleFacts.getCallSites(it->first);
+        if (callSites.empty()) {
+            continue;
+        }
+        auto& fCallSiteData = callSiteData[it->first];
+        for (const auto& callSite : callSites) {
+            if (fCallSiteData.find(callSite.caller) == fCallSiteData.end()) {
+                // Not capped, Double::POS_INFINITY marks loops and hot edges would all tie at it
+                fCallSiteData[callSite.caller] = m_moduleFacts.getCallFrequency(it->first, callSite.caller);
             }
         }
     }
     return callSiteData;
 }
 
+void WeightAssigningHelper::applyCallProfile(CallSiteData& callSiteData)
+{
+    const CallProfile& profile = *m_callProfile;
+    const auto& isProfiled = [&profile] (llvm::Function* caller, llvm::Function* callee) {
+        return profile.hasFunction(caller) && profile.hasFunction(callee);
+    };
+    // Static estimates are scaled to the measured counts of the edges both have, so that fallback values are comparable
+    double measuredCalls = 0;
+    double estimatedCalls = 0;
+    for (const auto& [callee, callers] : callSiteData) {
+        for (const auto& [caller, calls] : callers) {
+            if (isProfiled(caller, callee)) {
+                measuredCalls += profile.getCallsNum(caller, callee);
+                estimatedCalls += calls;
+            }
+        }
+    }
+    const double scale = (measuredCalls == 0 || estimatedCalls == 0) ? 1 : measuredCalls / estimatedCalls;
+    double profileWeight = ProfileWeight;
+    if (!(profileWeight >= 0 && profileWeight <= 1)) {
+        // Weights out of range would make call weights negative
+        profileWeight = profileWeight > 1 ? 1 : 0;
+        m_logger.warn("Profile weight " + std::to_string(ProfileWeight) + " is not between 0 and 1, using "
+                      + std::to_string(profileWeight));
+    }
+    unsigned profiledEdges = 0;
+    unsigned fallbackEdges = 0;
+    for (auto& [callee, callers] : callSiteData) {
+        for (auto& [caller, calls] : callers) {
+            const double estimate = calls.getValue() * scale;
+            if (isProfiled(caller, callee)) {
+                calls = profileWeight * profile.getCallsNum(caller, callee) + (1 - profileWeight) * estimate;
+                ++profiledEdges;
+            } else {
+                // Profile run did not execute caller or callee, keep static estimate
+                calls = estimate;
+                ++fallbackEdges;
+            }
+        }
+    }
+    m_logger.info("Call profile: " + std::to_string(profiledEdges) + " measured edges, "
+                  + std::to_string(fallbackEdges) + " edges with static estimates");
+    // Calls from external code have no edges in the call graph, report the ones entering the enclave
+    for (llvm::Function* F : m_securePartition.getPartition()) {
+        const double externalCalls = profile.getExternalCallsNum(F);
+        if (externalCalls > 0) {
+            m_logger.warn("Secure function " + F->getName().str() + " entered "
+                          + std::to_string((long)externalCalls) + " times from external code");
+        }
+    }
+}
+
+void WeightAssigningHelper::applyCallRates(CallSiteData& callSiteData)
+{
+    for (auto& [callee, callers] : callSiteData) {
+        if (!m_hints.hasCallRate(callee) || callers.empty()) {
+            continue;
+        }
+        const double rate = m_hints.getCallRate(callee);
+        double estimatedCalls = 0;
+        for (const auto& [caller, calls] : callers) {
+            estimatedCalls += calls;
+        }
+        // Rate is distributed over callers in proportion to their estimated calls
+        for (auto& [caller, calls] : callers) {
+            const double share = estimatedCalls == 0 ? 1.0 / callers.size() : calls.getValue() / estimatedCalls;
+            calls = rate * share;
+        }
+    }
+}
+
+void WeightAssigningHelper::applyLatencyCriticalCalls(CallSiteData& callSiteData)
+{
+    double maxCalls = 0;
+    for (const auto& [callee, callers] : callSiteData) {
+        for (const auto& [caller, calls] : callers) {
+            maxCalls = std::max(maxCalls, calls.getValue());
+        }
+    }
+    // Critical calls weigh as much as the most frequent call, so that optimizers do not cut them
+    for (auto& [callee, callers] : callSiteData) {
+        for (auto& [caller, calls] : callers) {
+            if (m_hints.isLatencyCritical(caller, callee)) {
+                calls = maxCalls;
+            }
+        }
+    }
+}
+
 void WeightAssigningHelper::normalizeWeights()
 {
     m_logger.info("Normalizing weights");
@@ -552,14 +758,47 @@ Node* CallGraph::getFunctionNode(llvm::Function* F) const
 
 void CallGraph::assignWeights(const Partition& securePartition,
                               const Partition& insecurePartition,
-                              const pdg::PDG* pdg,
-                              const LoopInfoGetter& loopInfoGetter)
+                              const ModuleFacts& moduleFacts,
+                              const PerformanceHints& hints)
 {
+    addIndirectCallEdges(securePartition, moduleFacts);
     m_logger.info("Computing weights for Augmented Call Graph");
-    WeightAssigningHelper helper(*this, securePartition, insecurePartition, pdg, loopInfoGetter, m_logger);
+    WeightAssigningHelper helper(*this, securePartition, insecurePartition, moduleFacts, hints, m_logger);
     helper.assignWeights();
 }
 
+void CallGraph::addIndirectCallEdges(const Partition& securePartition, const ModuleFacts& moduleFacts)
+{
+    std::vector<Node*> nodes;
+    nodes.reserve(m_functionNodes.size());
+    for (const auto& [F, node] : m_functionNodes) {
+        nodes.push_back(node.get());
+    }
+    unsigned edgesNum = 0;
+    unsigned crossingEdgesNum = 0;
+    for (Node* sinkNode : nodes) {
+        llvm::Function* F = sinkNode->getFunction();
+        for (const auto& callSite : moduleFacts.getCallSites(F)) {
+            // llvm::CallGraph has edges of calls with a called function only, calls through bitcasts included
+            if (callSite.callSite.getCalledFunction()) {
+                continue;
+            }
+            Node* sourceNode = getOrAddNode(callSite.caller);
+            Edge edge(sourceNode, sinkNode);
+            if (!sourceNode->addOutEdge(edge)) {
+                continue;
+            }
+            sinkNode->addInEdge(edge);
+            ++edgesNum;
+            if (securePartition.contains(callSite.caller) != securePartition.contains(F)) {
+                ++crossingEdgesNum;
+            }
+        }
+    }
+    m_logger.info("Added " + std::to_string(edgesNum) + " edges of indirect and cast calls, "
+                  + std::to_string(crossingEdgesNum) + " of them cross the partition boundary");
+}
+
 void CallGraph::create(const llvm::CallGraph& graph)
 {
     m_logger.info("Creating Augmented Call Graph");
@@ -613,11 +852,8 @@ bool CallGraphPass::runOnModule(llvm::Module& M)
     llvm::CallGraph& CG = getAnalysis<llvm::CallGraphWrapperPass>().getCallGraph();
     m_callgraph.reset(new CallGraph(CG, logger));
     auto* partition = &getAnalysis<vazgen::ProgramPartitionAnalysis>().getProgramPartition();
-    auto pdg = getAnalysis<pdg::SVFGPDGBuilder>().getPDG();
-    const auto& loopGetter = [this] (llvm::Function* F)
-        {   return &this->getAnalysis<llvm::LoopInfoWrapperPass>(*F).getLoopInfo(); };
     m_callgraph->assignWeights(partition->getSecurePartition(), partition->getInsecurePartition(),
-                               pdg.get(), loopGetter);
+                               partition->getModuleFacts(), partition->getPerformanceHints());
     return false;
 }
 
@@ -0,0 +1,98 @@
+#include "Analysis/CallProfile.h"
+
+#include "Utils/Logger.h"
+
+#include "llvm/IR/Function.h"
+
+#include <fstream>
+#include <sstream>
+
+namespace vazgen {
+
+const std::string CallProfile::EXTERNAL_CALLER = "external";
+
+CallProfile::CallProfile(Logger& logger)
+    : m_logger(logger)
+{
+}
+
+bool CallProfile::load(const std::string& fileName)
+{
+    std::ifstream ifs(fileName, std::ifstream::in);
+    if (!ifs.is_open()) {
+        m_logger.error("Could not open call profile " + fileName);
+        return false;
+    }
+    m_logger.info("Reading call profile from " + fileName);
+    std::string line;
+    unsigned lineNum = 0;
+    while (std::getline(ifs, line)) {
+        ++lineNum;
+        if (line.empty()) {
+            continue;
+        }
+        // (caller callee) count
+        const auto open = line.find('(');
+        const auto close = line.find(')');
+        std::string caller;
+        std::string callee;
+        double callsNum = 0;
+        if (open == std::string::npos || close == std::string::npos || close < open) {
+            m_logger.warn("Skipping malformed call profile line " + std::to_string(lineNum));
+            continue;
+        }
+        std::istringstream edgeStrm(line.substr(open + 1, close - open - 1));
+        std::istringstream countStrm(line.substr(close + 1));
+        if (!(edgeStrm >> caller >> callee) || !(countStrm >> callsNum)) {
+            m_logger.warn("Skipping malformed call profile line " + std::to_string(lineNum));
+            continue;
+        }
+        m_calls[callee][caller] += callsNum;
+        m_functions.insert(callee);
+        if (caller != EXTERNAL_CALLER) {
+            m_functions.insert(caller);
+        }
+    }
+    return true;
+}
+
+bool CallProfile::hasFunction(llvm::Function* F) const
+{
+    return m_functions.find(F->getName().str()) != m_functions.end();
+}
+
+double CallProfile::getCallsNum(llvm::Function* caller, llvm::Function* callee) const
+{
+    return getCallsNum(caller->getName().str(), callee->getName().str());
+}
+
+double CallProfile::getExternalCallsNum(llvm::Function* callee) const
+{
+    return getCallsNum(EXTERNAL_CALLER, callee->getName().str());
+}
+
+double CallProfile::getEntriesNum(llvm::Function* F) const
+{
+    auto calleePos = m_calls.find(F->getName().str());
+    if (calleePos == m_calls.end()) {
+        return 0;
+    }
+    double entries = 0;
+    for (const auto& [caller, calls] : calleePos->second) {
+        entries += calls;
+    }
+    return entries;
+}
+
+double CallProfile::getCallsNum(const std::string& caller, const std::string& callee) const
+{
+    auto calleePos = m_calls.find(callee);
+    if (calleePos == m_calls.end()) {
+        return 0;
+    }
+    auto callerPos = calleePos->second.find(caller);
+    return callerPos == calleePos->second.end() ? 0 : callerPos->second;
+}
+
+} // namespace vazgen
+
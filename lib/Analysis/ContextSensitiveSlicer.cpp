@@ -0,0 +1,207 @@
+#include "Analysis/ContextSensitiveSlicer.h"
+
+#include "PDG/PDG/PDG.h"
+
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+
+#include <algorithm>
+
+namespace vazgen {
+
+namespace {
+
+const unsigned ENTRY_SHIFT = 32;
+
+std::uint64_t getPathEdgeKey(unsigned entry, unsigned node)
+{
+    return (static_cast<std::uint64_t>(entry) << ENTRY_SHIFT) | node;
+}
+
+}
+
+ContextSensitiveSlicer::ContextSensitiveSlicer(PDGType pdg, const PDGSnapshot& pdgSnapshot)
+    : m_pdg(pdg)
+    , m_pdgSnapshot(pdgSnapshot)
+{
+}
+
+ContextSensitiveSlicer::SummaryType ContextSensitiveSlicer::slice(unsigned node, SliceSummaries::Direction direction)
+{
+    const bool forward = (direction == SliceSummaries::FORWARD);
+    const bool throughNonValueNodes = (direction == SliceSummaries::RETURN_BACKWARD);
+    SliceSummaryBuilder builder;
+    // Phase 0 ascends to callers and steps over call sites, phase 1 descends into callees
+    RingBuffer<unsigned> workingLists[2];
+    std::vector<std::uint8_t> processedNodes(m_pdgSnapshot.size());
+    workingLists[0].push(node);
+
+    for (unsigned phase = 0; phase < 2; ++phase) {
+        auto& workingList = workingLists[phase];
+        while (!workingList.empty()) {
+            const unsigned currentNode = workingList.pop();
+            if (!m_pdgSnapshot.isLLVMNode(currentNode)) {
+                continue;
+            }
+            auto* nodeValue = m_pdgSnapshot.getValue(currentNode);
+            if (!nodeValue && !throughNonValueNodes) {
+                continue;
+            }
+            // Nodes reached in the first phase have been processed with less restrictions
+            if ((processedNodes[currentNode] & 1) || (processedNodes[currentNode] & (1 << phase))) {
+                continue;
+            }
+            processedNodes[currentNode] |= (1 << phase);
+            if (m_pdgSnapshot.getKind(currentNode) == PDGSnapshot::FUNCTION) {
+                auto* F = m_pdgSnapshot.getNodeFunction(currentNode);
+                if (!F->isDeclaration()) {
+                    builder.addReachedFunction(F);
+                }
+                // Stop traversal here
+                continue;
+            }
+            if (forward && nodeValue && llvm::isa<llvm::StoreInst>(nodeValue)) {
+                builder.addStoredValue(llvm::cast<llvm::StoreInst>(nodeValue)->getValueOperand());
+            }
+            auto* currentParent = m_pdgSnapshot.getParent(currentNode);
+            for (auto nextNode : getNextNodes(currentNode, forward)) {
+                if (!m_pdgSnapshot.canProcessNode(nextNode)) {
+                    continue;
+                }
+                const auto edgeKind = getEdgeKind(currentNode, nextNode);
+                if (edgeKind == ASCEND && phase == 1) {
+                    continue;
+                }
+                builder.addFunctionEdge(currentParent, m_pdgSnapshot.getParent(nextNode));
+                if (edgeKind != DESCEND) {
+                    workingList.push(nextNode);
+                    continue;
+                }
+                if (forward && m_pdgSnapshot.isPointerActualArg(currentNode)) {
+                    auto* F = m_pdgSnapshot.getNodeFunction(nextNode);
+                    if (F && m_pdg->hasFunctionPDG(F) && !F->isDeclaration()) {
+                        builder.addCalledFunction(F);
+                    }
+                }
+                workingLists[1].push(nextNode);
+                for (auto target : getSummaryEdges(currentNode, forward)) {
+                    workingList.push(target);
+                }
+            }
+        }
+    }
+    return builder.getSummary();
+}
+
+ContextSensitiveSlicer::EdgeKind ContextSensitiveSlicer::getEdgeKind(unsigned from, unsigned to) const
+{
+    if (m_pdgSnapshot.getParent(from) == m_pdgSnapshot.getParent(to)) {
+        return INTRA;
+    }
+    const auto fromKind = m_pdgSnapshot.getKind(from);
+    const auto toKind = m_pdgSnapshot.getKind(to);
+    if (fromKind == PDGSnapshot::ACTUAL_ARG && toKind == PDGSnapshot::FORMAL_ARG) {
+        return DESCEND;
+    }
+    if (fromKind == PDGSnapshot::FORMAL_ARG && toKind == PDGSnapshot::ACTUAL_ARG) {
+        return ASCEND;
+    }
+    return OTHER;
+}
+
+PDGSnapshot::EdgeRange ContextSensitiveSlicer::getNextNodes(unsigned node, bool forward) const
+{
+    return forward ? m_pdgSnapshot.getOutEdges(node) : m_pdgSnapshot.getInEdges(node);
+}
+
+PDGSnapshot::EdgeRange ContextSensitiveSlicer::getPreviousNodes(unsigned node, bool forward) const
+{
+    return forward ? m_pdgSnapshot.getInEdges(node) : m_pdgSnapshot.getOutEdges(node);
+}
+
+bool ContextSensitiveSlicer::canTraverse(unsigned node) const
+{
+    return m_pdgSnapshot.isLLVMNode(node)
+        && m_pdgSnapshot.canProcessNode(node)
+        && m_pdgSnapshot.getKind(node) != PDGSnapshot::FUNCTION;
+}
+
+std::vector<unsigned> ContextSensitiveSlicer::getSummaryEdges(unsigned actualArgNode, bool forward)
+{
+    auto& tabulation = m_tabulations[forward];
+    std::lock_guard<std::mutex> lock(tabulation.mutex);
+    for (auto nextNode : getNextNodes(actualArgNode, forward)) {
+        if (canTraverse(nextNode) && getEdgeKind(actualArgNode, nextNode) == DESCEND) {
+            addPathEdge(tabulation, nextNode, nextNode);
+        }
+    }
+    tabulate(forward);
+    return tabulation.summaryEdges[actualArgNode];
+}
+
+void ContextSensitiveSlicer::tabulate(bool forward)
+{
+    auto& tabulation = m_tabulations[forward];
+    while (!tabulation.workingList.empty()) {
+        const std::uint64_t pathEdge = tabulation.workingList.pop();
+        const unsigned entry = pathEdge >> ENTRY_SHIFT;
+        const unsigned node = pathEdge & 0xffffffff;
+        if (m_pdgSnapshot.getKind(node) == PDGSnapshot::ACTUAL_ARG) {
+            tabulation.actualArgEntries[node].push_back(entry);
+            // copied as new path edges may add summary edges
+            const auto targets = tabulation.summaryEdges[node];
+            for (auto target : targets) {
+                addPathEdge(tabulation, entry, target);
+            }
+        }
+        for (auto nextNode : getNextNodes(node, forward)) {
+            if (!canTraverse(nextNode)) {
+                continue;
+            }
+            switch (getEdgeKind(node, nextNode)) {
+            case INTRA:
+                addPathEdge(tabulation, entry, nextNode);
+                break;
+            case DESCEND:
+                addPathEdge(tabulation, nextNode, nextNode);
+                break;
+            case ASCEND:
+                // Flow leaves the entry's function, connect actual arguments of call sites entering it
+                for (auto callerNode : getPreviousNodes(entry, forward)) {
+                    if (getEdgeKind(callerNode, entry) == DESCEND
+                            && m_pdgSnapshot.getCallSite(callerNode) == m_pdgSnapshot.getCallSite(nextNode)) {
+                        addSummaryEdge(tabulation, callerNode, nextNode);
+                    }
+                }
+                break;
+            case OTHER:
+                // Not part of same level paths, slicing follows these edges in both phases
+                break;
+            }
+        }
+    }
+}
+
+void ContextSensitiveSlicer::addPathEdge(Tabulation& tabulation, unsigned entry, unsigned node)
+{
+    const auto key = getPathEdgeKey(entry, node);
+    if (tabulation.pathEdges.insert(key).second) {
+        tabulation.workingList.push(key);
+    }
+}
+
+void ContextSensitiveSlicer::addSummaryEdge(Tabulation& tabulation, unsigned actualArgNode, unsigned target)
+{
+    auto& targets = tabulation.summaryEdges[actualArgNode];
+    if (std::find(targets.begin(), targets.end(), target) != targets.end()) {
+        return;
+    }
+    targets.push_back(target);
+    const auto entries = tabulation.actualArgEntries[actualArgNode];
+    for (auto entry : entries) {
+        addPathEdge(tabulation, entry, target);
+    }
+}
+
+} // namespace vazgen
+
@@ -0,0 +1,387 @@
+#include "Analysis/EnclaveSizing.h"
+
+#include "Analysis/ModuleFacts.h"
+#include "Utils/Logger.h"
+
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
+
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <unordered_set>
+
+llvm::cl::opt<unsigned> EnclaveRecursionDepth(
+    "enclave-recursion-depth",
+    llvm::cl::desc("Assumed depth of recursion when sizing enclave stack. Defaults to 16"),
+    llvm::cl::value_desc("depth"),
+    llvm::cl::init(16));
+
+namespace vazgen {
+
+namespace {
+
+// Return address, frame pointer and callee saved registers
+const long FRAME_OVERHEAD_BYTES = 64;
+// Allocas of non constant size
+const long DYNAMIC_ALLOCA_BYTES = 4096;
+// Frames of library functions the enclave calls
+const long EXTERNAL_CALL_STACK_BYTES = 1024;
+// Allocations of non constant size
+const long UNKNOWN_ALLOCATION_BYTES = 64 * 1024;
+const long PAGE_SIZE = 4096;
+const long MIN_STACK_SIZE = 16 * PAGE_SIZE;
+const long MIN_HEAP_SIZE = 256 * PAGE_SIZE;
+// Margin for frame size estimation errors and runtime allocation patterns
+const long SAFETY_FACTOR = 2;
+// Threads assumed for a thread creation site in a loop of unknown trip count
+const double UNKNOWN_LOOP_THREADS = 8;
+// Threads started at one site are rarely all alive at once
+const double MAX_SITE_THREADS = 64;
+
+long roundToPages(long size)
+{
+    return (size + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+}
+
+// Argument indices of the size, 0 based, of known allocation functions. calloc multiplies two arguments
+const std::unordered_map<std::string, std::vector<unsigned>>& getAllocationFunctions()
+{
+    static const std::unordered_map<std::string, std::vector<unsigned>> allocationFunctions = {
+        {"malloc", {0}},
+        {"calloc", {0, 1}},
+        {"realloc", {1}},
+        {"aligned_alloc", {1}},
+        {"memalign", {1}},
+        {"posix_memalign", {2}},
+        {"_Znwm", {0}},
+        {"_Znam", {0}},
+        {"strdup", {}},
+        {"strndup", {1}}
+    };
+    return allocationFunctions;
+}
+
+/// Tarjan's algorithm over the enclave call graph, SCCs are found callees first
+class SCCFinder
+{
+public:
+    using CalleesGetter = std::function<std::vector<llvm::Function*> (llvm::Function*)>;
+    using SCC = std::vector<llvm::Function*>;
+
+public:
+    explicit SCCFinder(const CalleesGetter& calleesGetter)
+        : m_calleesGetter(calleesGetter)
+    {
+    }
+
+    // Iterative, as call chains of large programs may overflow the native stack
+    void visit(llvm::Function* root)
+    {
+        if (m_indices.find(root) != m_indices.end()) {
+            return;
+        }
+        std::vector<Frame> frames;
+        enter(root, frames);
+        while (!frames.empty()) {
+            Frame& frame = frames.back();
+            llvm::Function* F = frame.function;
+            if (frame.nextCallee < frame.callees.size()) {
+                llvm::Function* callee = frame.callees[frame.nextCallee++];
+                if (m_indices.find(callee) == m_indices.end()) {
+                    // invalidates frame
+                    enter(callee, frames);
+                } else if (m_onStack.find(callee) != m_onStack.end()) {
+                    m_lowLinks[F] = std::min(m_lowLinks[F], m_indices[callee]);
+                }
+                continue;
+            }
+            frames.pop_back();
+            if (!frames.empty()) {
+                llvm::Function* caller = frames.back().function;
+                m_lowLinks[caller] = std::min(m_lowLinks[caller], m_lowLinks[F]);
+            }
+            if (m_lowLinks[F] != m_indices[F]) {
+                continue;
+            }
+            SCC scc;
+            llvm::Function* sccF = nullptr;
+            do {
+                sccF = m_stack.back();
+                m_stack.pop_back();
+                m_onStack.erase(sccF);
+                scc.push_back(sccF);
+            } while (sccF != F);
+            m_sccs.push_back(std::move(scc));
+        }
+    }
+
+    const std::vector<SCC>& getSCCs() const
+    {
+        return m_sccs;
+    }
+
+private:
+    struct Frame
+    {
+        llvm::Function* function;
+        std::vector<llvm::Function*> callees;
+        unsigned nextCallee;
+    }; // struct Frame
+
+    void enter(llvm::Function* F, std::vector<Frame>& frames)
+    {
+        const unsigned index = m_indices.size();
+        m_indices[F] = index;
+        m_lowLinks[F] = index;
+        m_stack.push_back(F);
+        m_onStack.insert(F);
+        frames.push_back(Frame{F, m_calleesGetter(F), 0});
+    }
+
+private:
+    const CalleesGetter& m_calleesGetter;
+    std::unordered_map<llvm::Function*, unsigned> m_indices;
+    std::unordered_map<llvm::Function*, unsigned> m_lowLinks;
+    std::vector<llvm::Function*> m_stack;
+    std::unordered_set<llvm::Function*> m_onStack;
+    std::vector<SCC> m_sccs;
+}; // class SCCFinder
+
+} // unnamed namespace
+
+EnclaveSizing::EnclaveSizing(llvm::Module& enclaveModule,
+                             llvm::Module& programModule,
+                             const ModuleFacts& programFacts,
+                             Logger& logger)
+    : m_enclaveModule(enclaveModule)
+    , m_programModule(programModule)
+    , m_programFacts(programFacts)
+    , m_logger(logger)
+    , m_maxStackDepth(0)
+    , m_stackSize(0)
+    , m_heapSize(0)
+    , m_tcsNum(1)
+    , m_hasDynamicAllocas(false)
+{
+    for (auto& F : m_enclaveModule) {
+        if (!F.isDeclaration() && F.hasAddressTaken()) {
+            m_addressTakenFunctions.push_back(&F);
+        }
+    }
+}
+
+void EnclaveSizing::estimate()
+{
+    m_logger.info("Estimating enclave stack, heap and TCS requirements");
+    estimateStack();
+    estimateHeap();
+    estimateTCSNum();
+    m_logger.info("Recommended enclave stack " + std::to_string(m_stackSize) + " bytes, heap "
+                  + std::to_string(m_heapSize) + " bytes, " + std::to_string(m_tcsNum) + " TCS");
+}
+
+void EnclaveSizing::dump(const std::string& fileName) const
+{
+    nlohmann::json root;
+    root["stack_size"] = m_stackSize;
+    root["heap_size"] = m_heapSize;
+    root["tcs_num"] = m_tcsNum;
+    root["max_stack_depth"] = m_maxStackDepth;
+    root["dynamic_allocas"] = m_hasDynamicAllocas;
+    root["recursive_functions"] = nlohmann::json::array();
+    for (auto* F : m_recursiveFunctions) {
+        root["recursive_functions"].push_back(F->getName().str());
+    }
+    root["allocation_sites"] = nlohmann::json::array();
+    for (const auto& site : m_allocationSites) {
+        nlohmann::json siteItem;
+        siteItem["function"] = site.function->getName().str();
+        if (site.size != 0) {
+            siteItem["size"] = site.size;
+        }
+        root["allocation_sites"].push_back(siteItem);
+    }
+    std::ofstream ostr(fileName);
+    ostr << root.dump(4) << "\n";
+}
+
+void EnclaveSizing::estimateStack()
+{
+    const SCCFinder::CalleesGetter calleesGetter = [this] (llvm::Function* F) { return getCallees(F); };
+    SCCFinder sccFinder(calleesGetter);
+    for (auto& F : m_enclaveModule) {
+        if (!F.isDeclaration()) {
+            sccFinder.visit(&F);
+        }
+    }
+    // Deepest stack starting at a function, SCCs come callees first
+    std::unordered_map<llvm::Function*, long> stackDepths;
+    for (const auto& scc : sccFinder.getSCCs()) {
+        const std::unordered_set<llvm::Function*> sccFunctions(scc.begin(), scc.end());
+        long sccFrames = 0;
+        long calleesDepth = 0;
+        bool isRecursive = scc.size() > 1;
+        for (auto* F : scc) {
+            sccFrames += getFrameSize(F);
+            for (auto* callee : getCallees(F)) {
+                if (sccFunctions.find(callee) != sccFunctions.end()) {
+                    isRecursive = true;
+                    continue;
+                }
+                calleesDepth = std::max(calleesDepth, stackDepths[callee]);
+            }
+            for (auto& B : *F) {
+                for (auto& I : B) {
+                    llvm::CallSite callSite(&I);
+                    if (callSite && callSite.getCalledFunction() && callSite.getCalledFunction()->isDeclaration()
+                            && !callSite.getCalledFunction()->isIntrinsic()) {
+                        calleesDepth = std::max(calleesDepth, EXTERNAL_CALL_STACK_BYTES);
+                    }
+                }
+            }
+        }
+        long depth = 0;
+        if (isRecursive) {
+            // Every function of the cycle is assumed on stack at every level of recursion
+            depth = sccFrames * EnclaveRecursionDepth + calleesDepth;
+            m_recursiveFunctions.insert(m_recursiveFunctions.end(), scc.begin(), scc.end());
+        } else {
+            depth = sccFrames + calleesDepth;
+        }
+        for (auto* F : scc) {
+            stackDepths[F] = depth;
+        }
+        m_maxStackDepth = std::max(m_maxStackDepth, depth);
+    }
+    if (!m_recursiveFunctions.empty()) {
+        m_logger.warn("Enclave has " + std::to_string(m_recursiveFunctions.size())
+                      + " recursive functions, stack assumes recursion depth " + std::to_string(EnclaveRecursionDepth));
+    }
+    m_stackSize = std::max(MIN_STACK_SIZE, roundToPages(m_maxStackDepth * SAFETY_FACTOR));
+}
+
+void EnclaveSizing::estimateHeap()
+{
+    const auto& allocationFunctions = getAllocationFunctions();
+    long heapSize = 0;
+    for (auto& F : m_enclaveModule) {
+        for (auto& B : F) {
+            for (auto& I : B) {
+                llvm::CallSite callSite(&I);
+                if (!callSite || !callSite.getCalledFunction()) {
+                    continue;
+                }
+                auto pos = allocationFunctions.find(callSite.getCalledFunction()->getName().str());
+                if (pos == allocationFunctions.end()) {
+                    continue;
+                }
+                long size = pos->second.empty() ? 0 : 1;
+                for (unsigned argIdx : pos->second) {
+                    auto* constSize = llvm::dyn_cast<llvm::ConstantInt>(callSite.getArgument(argIdx));
+                    if (!constSize) {
+                        size = 0;
+                        break;
+                    }
+                    size *= constSize->getSExtValue();
+                }
+                m_allocationSites.push_back(AllocationSite{&F, size});
+                heapSize += size == 0 ? UNKNOWN_ALLOCATION_BYTES : size;
+            }
+        }
+    }
+    m_heapSize = std::max(MIN_HEAP_SIZE, roundToPages(heapSize * SAFETY_FACTOR));
+}
+
+void EnclaveSizing::estimateTCSNum()
+{
+    // Each thread created may enter the enclave, in addition to the main thread
+    unsigned threadSites = 0;
+    unsigned unknownLoopSites = 0;
+    double threads = 0;
+    for (auto& F : m_programModule) {
+        for (auto& B : F) {
+            for (auto& I : B) {
+                llvm::CallSite callSite(&I);
+                if (!callSite || !callSite.getCalledFunction()
+                        || callSite.getCalledFunction()->getName() != "pthread_create") {
+                    continue;
+                }
+                ++threadSites;
+                // Sites in loops start a thread per iteration, e.g. worker pools
+                double siteThreads = m_programFacts.getBlockFrequency(&B)
+                                   * std::max(m_programFacts.getFunctionFrequency(&F), 1.0);
+                if (!m_programFacts.hasKnownTripCounts(&B)) {
+                    siteThreads = std::max(siteThreads, UNKNOWN_LOOP_THREADS);
+                    ++unknownLoopSites;
+                }
+                threads += std::min(std::max(std::ceil(siteThreads), 1.0), MAX_SITE_THREADS);
+            }
+        }
+    }
+    m_tcsNum = 1 + static_cast<unsigned>(threads);
+    if (threadSites != 0) {
+        m_logger.info("Program creates threads at " + std::to_string(threadSites) + " sites, TCS hint assumes "
+                      + std::to_string(m_tcsNum - 1) + " threads, " + std::to_string(unknownLoopSites)
+                      + " sites are in loops of unknown trip count");
+    }
+}
+
+long EnclaveSizing::getFrameSize(llvm::Function* F)
+{
+    const auto& dataLayout = m_enclaveModule.getDataLayout();
+    long frameSize = FRAME_OVERHEAD_BYTES;
+    for (auto& B : *F) {
+        for (auto& I : B) {
+            auto* alloca = llvm::dyn_cast<llvm::AllocaInst>(&I);
+            if (!alloca) {
+                continue;
+            }
+            auto* arraySize = llvm::dyn_cast<llvm::ConstantInt>(alloca->getArraySize());
+            if (!arraySize) {
+                frameSize += DYNAMIC_ALLOCA_BYTES;
+                m_hasDynamicAllocas = true;
+                continue;
+            }
+            frameSize += dataLayout.getTypeAllocSize(alloca->getAllocatedType()) * arraySize->getZExtValue();
+        }
+    }
+    return frameSize;
+}
+
+std::vector<llvm::Function*> EnclaveSizing::getCallees(llvm::Function* F) const
+{
+    std::vector<llvm::Function*> callees;
+    std::unordered_set<llvm::Function*> seen;
+    for (auto& B : *F) {
+        for (auto& I : B) {
+            llvm::CallSite callSite(&I);
+            if (!callSite) {
+                continue;
+            }
+            if (auto* callee = callSite.getCalledFunction()) {
+                if (!callee->isDeclaration() && seen.insert(callee).second) {
+                    callees.push_back(callee);
+                }
+            } else if (!callSite.isInlineAsm()) {
+                for (auto* target : m_addressTakenFunctions) {
+                    if (seen.insert(target).second) {
+                        callees.push_back(target);
+                    }
+                }
+            }
+        }
+    }
+    return callees;
+}
+
+} // namespace vazgen
+
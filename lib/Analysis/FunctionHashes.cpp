@@ -0,0 +1,66 @@
+#include "Analysis/FunctionHashes.h"
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/ModuleSlotTracker.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+
+namespace vazgen {
+
+FunctionHashes::FunctionHashes(llvm::Module& M)
+    : m_module(M)
+{
+    computeHashes();
+}
+
+std::uint64_t FunctionHashes::getHash(llvm::Function* F) const
+{
+    auto pos = m_hashes.find(F->getName().str());
+    return pos == m_hashes.end() ? 0 : pos->second;
+}
+
+void FunctionHashes::computeHashes()
+{
+    llvm::SmallVector<llvm::StringRef, 16> metadataKinds;
+    m_module.getMDKindNames(metadataKinds);
+    llvm::ModuleSlotTracker slotTracker(&m_module);
+    for (auto& F : m_module) {
+        std::string content;
+        llvm::raw_string_ostream contentStrm(content);
+        F.getFunctionType()->print(contentStrm);
+        contentStrm << " " << F.getLinkage() << " " << F.getCallingConv() << "\n";
+        // Values are printed with slots local to the function
+        slotTracker.incorporateFunction(F);
+        llvm::SmallVector<std::pair<unsigned, llvm::MDNode*>, 4> attachments;
+        for (auto& I : llvm::instructions(F)) {
+            if (llvm::isa<llvm::DbgInfoIntrinsic>(&I)) {
+                continue;
+            }
+            std::string instruction;
+            llvm::raw_string_ostream instructionStrm(instruction);
+            I.print(instructionStrm, slotTracker);
+            instructionStrm.flush();
+            // Attachments are printed last, e.g. ", !dbg !42"
+            attachments.clear();
+            I.getAllMetadata(attachments);
+            std::size_t end = instruction.size();
+            for (const auto& [kind, node] : attachments) {
+                if (kind < metadataKinds.size()) {
+                    end = std::min(end, instruction.find(", !" + metadataKinds[kind].str() + " "));
+                }
+            }
+            contentStrm << instruction.substr(0, end) << "\n";
+        }
+        m_hashes[F.getName().str()] = llvm::MD5Hash(contentStrm.str());
+    }
+}
+
+} // namespace vazgen
+
@@ -0,0 +1,155 @@
+#include "Analysis/LibraryCalls.h"
+
+#include "Utils/Logger.h"
+
+#include "llvm/IR/Function.h"
+#include "llvm/Support/CommandLine.h"
+
+#include "nlohmann/json.hpp"
+
+#include <fstream>
+#include <vector>
+
+llvm::cl::opt<std::string> LibraryCallsFile(
+    "library-calls",
+    llvm::cl::desc("Json file classifying external functions as enclave_safe, requires_ocall or forbidden"),
+    llvm::cl::value_desc("library calls file"));
+
+namespace vazgen {
+
+namespace {
+
+// Routines of the trusted libc, which only touch memory given to them.
+// Functions taking callbacks, e.g. qsort and bsearch, are not listed, as an untrusted callback crosses on every call
+const std::vector<std::string> ENCLAVE_SAFE_FUNCTIONS = {
+    "memcpy", "memmove", "memset", "memcmp", "memchr", "bzero",
+    "strlen", "strnlen", "strcmp", "strncmp", "strcasecmp", "strncasecmp", "strcoll",
+    "strcpy", "strncpy", "strcat", "strncat", "strchr", "strrchr", "strstr", "strspn", "strcspn",
+    "strpbrk", "strtok_r", "strdup", "strndup",
+    "malloc", "calloc", "realloc", "free", "memalign", "posix_memalign",
+    "_Znwm", "_Znam", "_ZdlPv", "_ZdaPv",
+    "abs", "labs", "llabs", "div", "ldiv",
+    "atoi", "atol", "atoll", "atof", "strtol", "strtoul", "strtoll", "strtoull", "strtod", "strtof",
+    "isalpha", "isdigit", "isalnum", "isspace", "isupper", "islower", "isxdigit", "ispunct", "isprint",
+    "iscntrl", "isgraph", "toupper", "tolower",
+    "snprintf", "vsnprintf", "sprintf", "vsprintf",
+    "__errno_location", "abort", "__assert_fail", "__stack_chk_fail"
+};
+
+// Math functions are safe in their double, float and long double variants
+const std::vector<std::string> ENCLAVE_SAFE_MATH_FUNCTIONS = {
+    "sin", "cos", "tan", "asin", "acos", "atan", "atan2", "sinh", "cosh", "tanh",
+    "exp", "exp2", "expm1", "log", "log2", "log10", "log1p", "pow", "sqrt", "cbrt", "hypot",
+    "fabs", "floor", "ceil", "round", "lround", "trunc", "rint", "lrint", "nearbyint",
+    "fmod", "remainder", "fmin", "fmax", "frexp", "ldexp", "modf", "copysign"
+};
+
+// I/O and system calls, served by the untrusted runtime
+const std::vector<std::string> REQUIRES_OCALL_FUNCTIONS = {
+    "printf", "fprintf", "vprintf", "vfprintf", "puts", "putchar", "fputs", "fputc", "putc",
+    "scanf", "fscanf", "sscanf", "__isoc99_scanf", "__isoc99_fscanf", "__isoc99_sscanf",
+    "fopen", "fdopen", "fclose", "fread", "fwrite", "fflush", "fgets", "fgetc", "getc", "getchar",
+    "fseek", "ftell", "rewind", "feof", "ferror", "perror", "remove", "rename",
+    "open", "close", "read", "write", "pread", "pwrite", "lseek", "stat", "fstat", "lstat",
+    "unlink", "mkdir", "rmdir", "opendir", "readdir", "closedir",
+    "socket", "bind", "listen", "accept", "connect", "send", "recv", "sendto", "recvfrom",
+    "setsockopt", "getsockopt", "shutdown", "select", "poll", "epoll_wait",
+    "time", "gettimeofday", "clock_gettime", "clock", "sleep", "usleep", "nanosleep",
+    "getenv", "getpid", "rand", "srand", "random", "mmap", "munmap", "exit"
+};
+
+// Can not be served to an enclave without breaking its isolation
+const std::vector<std::string> FORBIDDEN_FUNCTIONS = {
+    "fork", "vfork", "execv", "execve", "execvp", "execl", "execlp", "execle", "system", "popen",
+    "dlopen", "dlsym", "syscall", "ptrace", "signal", "sigaction", "raise", "kill",
+    "setjmp", "_setjmp", "longjmp", "_longjmp"
+};
+
+}
+
+const LibraryCalls& LibraryCalls::get()
+{
+    static LibraryCalls libraryCalls;
+    return libraryCalls;
+}
+
+LibraryCalls::LibraryCalls()
+{
+    addBuiltins();
+    if (!LibraryCallsFile.empty()) {
+        Logger logger("program-partitioning");
+        load(LibraryCallsFile, logger);
+    }
+}
+
+LibraryCalls::Placement LibraryCalls::getPlacement(const llvm::Function* F) const
+{
+    if (F->isIntrinsic()) {
+        return ENCLAVE_SAFE;
+    }
+    auto pos = m_placements.find(F->getName().str());
+    return pos == m_placements.end() ? REQUIRES_OCALL : pos->second;
+}
+
+bool LibraryCalls::isEnclaveSafe(const llvm::Function* F) const
+{
+    return F->isDeclaration() && getPlacement(F) == ENCLAVE_SAFE;
+}
+
+bool LibraryCalls::isForbidden(const llvm::Function* F) const
+{
+    return F->isDeclaration() && getPlacement(F) == FORBIDDEN;
+}
+
+void LibraryCalls::addBuiltins()
+{
+    for (const auto& name : ENCLAVE_SAFE_FUNCTIONS) {
+        m_placements[name] = ENCLAVE_SAFE;
+    }
+    for (const auto& name : ENCLAVE_SAFE_MATH_FUNCTIONS) {
+        m_placements[name] = ENCLAVE_SAFE;
+        m_placements[name + "f"] = ENCLAVE_SAFE;
+        m_placements[name + "l"] = ENCLAVE_SAFE;
+    }
+    for (const auto& name : REQUIRES_OCALL_FUNCTIONS) {
+        m_placements[name] = REQUIRES_OCALL;
+    }
+    for (const auto& name : FORBIDDEN_FUNCTIONS) {
+        m_placements[name] = FORBIDDEN;
+    }
+}
+
+void LibraryCalls::load(const std::string& fileName, Logger& logger)
+{
+    std::ifstream ifs(fileName, std::ifstream::in);
+    if (!ifs.is_open()) {
+        logger.error("Can not open library calls file " + fileName);
+        return;
+    }
+    nlohmann::json root;
+    try {
+        ifs >> root;
+        const std::vector<std::pair<std::string, Placement>> sections = {
+            {"enclave_safe", ENCLAVE_SAFE},
+            {"requires_ocall", REQUIRES_OCALL},
+            {"forbidden", FORBIDDEN}
+        };
+        unsigned functionsNum = 0;
+        for (const auto& [section, placement] : sections) {
+            auto pos = root.find(section);
+            if (pos == root.end()) {
+                continue;
+            }
+            for (const auto& name : *pos) {
+                m_placements[name.get<std::string>()] = placement;
+                ++functionsNum;
+            }
+        }
+        logger.info("Loaded placements of " + std::to_string(functionsNum) + " library functions from " + fileName);
+    } catch (const nlohmann::json::exception& e) {
+        logger.error("Malformed library calls file " + fileName);
+    }
+}
+
+} // namespace vazgen
+
@@ -0,0 +1,636 @@
+#include "Analysis/ModuleFacts.h"
+
+#include "Analysis/FunctionHashes.h"
+#include "Analysis/LibraryCalls.h"
+#include "Utils/Logger.h"
+#include "Utils/Utils.h"
+
+#include "PDG/PDG/PDG.h"
+#include "PDG/PDG/FunctionPDG.h"
+
+#include "llvm/Analysis/BlockFrequencyInfo.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Type.h"
+#include "llvm/Support/CommandLine.h"
+
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <unordered_set>
+
+llvm::cl::opt<bool> PersistModuleFacts(
+    "persist-module-facts",
+    llvm::cl::desc("Reuse facts of unchanged functions across runs, keeping them in <module>.facts.json"),
+    llvm::cl::value_desc("flag to persist module facts"));
+
+namespace vazgen {
+
+namespace {
+
+// Bounds frequencies of recursive cycles which do not converge
+const double MAX_FREQUENCY = 1e12;
+const unsigned MAX_FREQUENCY_ITERATIONS = 64;
+const double FREQUENCY_EPSILON = 1e-3;
+// Length of strings is not known statically.
+// Charged for every i8* as it can not be told from a byte buffer, which may be copied with a different length
+const long STRING_BYTES = 64;
+// Average length of an x86-64 instruction
+const long INSTRUCTION_BYTES = 4;
+// Prologue, epilogue and alignment padding
+const long FUNCTION_OVERHEAD_BYTES = 16;
+
+}
+
+ModuleFacts::ModuleFacts(llvm::Module& M,
+                         const pdg::PDG& pdg,
+                         const FunctionAnalysesGetter& analysesGetter,
+                         Logger& logger)
+    : m_logger(logger)
+    , m_functionIndex(M.begin(), M.end())
+    , m_globalsIndex(M.global_begin(), M.global_end())
+    , m_functionFacts(m_functionIndex.size())
+    , m_moduleSize(0)
+    , m_moduleCodeSize(0)
+{
+    m_logger.info("Collecting module facts");
+    collectFunctionFacts(M);
+    AnalysedFactsCache cache;
+    if (!PersistModuleFacts) {
+        collectBlockFacts(M, pdg, analysesGetter, cache);
+    } else {
+        const std::string factsFile = M.getModuleIdentifier() + ".facts.json";
+        FunctionHashes hashes(M);
+        loadAnalysedFacts(M, factsFile, hashes, cache);
+        collectBlockFacts(M, pdg, analysesGetter, cache);
+        saveAnalysedFacts(factsFile, hashes, cache);
+    }
+    collectForbiddenCalls(M);
+    computeFunctionFrequencies(M);
+}
+
+int ModuleFacts::getFunctionSize(llvm::Function* F) const
+{
+    auto* facts = getFacts(F);
+    return facts ? facts->m_size : 0;
+}
+
+int ModuleFacts::getArgComplexity(llvm::Function* F) const
+{
+    auto* facts = getFacts(F);
+    return facts ? facts->m_argComplexity : 0;
+}
+
+int ModuleFacts::getReturnComplexity(llvm::Function* F) const
+{
+    auto* facts = getFacts(F);
+    return facts ? facts->m_retComplexity : 0;
+}
+
+const ModuleFacts::CallSiteFacts& ModuleFacts::getCallSites(llvm::Function* F) const
+{
+    static const CallSiteFacts noCallSites;
+    auto* facts = getFacts(F);
+    return facts ? facts->m_callSites : noCallSites;
+}
+
+bool ModuleFacts::hasCallSiteInLoop(llvm::Function* F, llvm::Function* caller) const
+{
+    for (const auto& callSite : getCallSites(F)) {
+        if (callSite.caller == caller && callSite.loopDepth != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+long ModuleFacts::getArgBytes(llvm::Function* F) const
+{
+    auto* facts = getFacts(F);
+    return facts ? facts->m_argBytes : 0;
+}
+
+long ModuleFacts::getReturnBytes(llvm::Function* F) const
+{
+    auto* facts = getFacts(F);
+    return facts ? facts->m_retBytes : 0;
+}
+
+double ModuleFacts::getMemoryOperations(llvm::Function* F) const
+{
+    auto* facts = getFacts(F);
+    return facts ? facts->m_memoryOps : 0;
+}
+
+bool ModuleFacts::callsForbiddenFunction(llvm::Function* F) const
+{
+    auto* facts = getFacts(F);
+    return facts && facts->m_callsForbidden;
+}
+
+double ModuleFacts::getFunctionFrequency(llvm::Function* F) const
+{
+    auto* facts = getFacts(F);
+    return facts ? facts->m_frequency : 0;
+}
+
+double ModuleFacts::getBlockFrequency(llvm::BasicBlock* block) const
+{
+    auto pos = m_blockFacts.find(block);
+    return pos == m_blockFacts.end() ? 1 : pos->second.m_frequency;
+}
+
+bool ModuleFacts::hasKnownTripCounts(llvm::BasicBlock* block) const
+{
+    auto pos = m_blockFacts.find(block);
+    return pos != m_blockFacts.end() && pos->second.m_tripCountsKnown;
+}
+
+double ModuleFacts::getCallFrequency(llvm::Function* F, llvm::Function* caller) const
+{
+    double frequency = 0;
+    for (const auto& callSite : getCallSites(F)) {
+        if (callSite.caller == caller) {
+            frequency += callSite.frequency;
+        }
+    }
+    return std::min(frequency * getFunctionFrequency(caller), MAX_FREQUENCY);
+}
+
+long ModuleFacts::getCodeSize(llvm::Function* F) const
+{
+    auto* facts = getFacts(F);
+    return facts ? facts->m_codeSize : 0;
+}
+
+long ModuleFacts::getModuleSize() const
+{
+    return m_moduleSize;
+}
+
+long ModuleFacts::getModuleCodeSize() const
+{
+    return m_moduleCodeSize;
+}
+
+int ModuleFacts::getTypeComplexity(llvm::Type* type) const
+{
+    auto pos = m_typeComplexities.find(type);
+    if (pos != m_typeComplexities.end()) {
+        return pos->second;
+    }
+    int complexity = 0;
+    if (auto* structType = llvm::dyn_cast<llvm::StructType>(type)) {
+        for (auto it = structType->element_begin(); it != structType->element_end(); ++it) {
+            complexity += getTypeComplexity(*it);
+        }
+    } else if (auto* arrayType = llvm::dyn_cast<llvm::ArrayType>(type)) {
+        complexity += arrayType->getNumElements() * getTypeComplexity(arrayType->getElementType());
+    } else if (auto* vectorType = llvm::dyn_cast<llvm::VectorType>(type)) {
+        complexity += vectorType->getNumElements() * getTypeComplexity(vectorType->getElementType());
+    } else if (llvm::isa<llvm::PointerType>(type)) {
+        // TODO: think about the cost for this
+    } else if (llvm::isa<llvm::FunctionType>(type)) {
+        // TODO: think about the cost for this, probably should be very high
+    } else {
+        complexity += 1;
+    }
+    return complexity;
+}
+
+void ModuleFacts::collectFunctionFacts(llvm::Module& M)
+{
+    const auto& dataLayout = M.getDataLayout();
+    for (auto& F : M) {
+        auto& facts = getMutableFacts(&F);
+        facts.m_size = Utils::getFunctionSize(&F);
+        if (!F.isDeclaration()) {
+            m_moduleSize += facts.m_size;
+        }
+        for (auto it = F.arg_begin(); it != F.arg_end(); ++it) {
+            facts.m_argComplexity += computeTypeComplexity(it->getType());
+            const long bytes = computeMarshalingBytes(it->getType(), dataLayout);
+            facts.m_argBytes += bytes;
+            const bool copiedBack = it->getType()->isPointerTy()
+                    && !it->hasByValAttr()
+                    && !it->onlyReadsMemory()
+                    && !F.onlyReadsMemory();
+            if (copiedBack) {
+                facts.m_argBytes += bytes - dataLayout.getPointerSize();
+            }
+        }
+        facts.m_retComplexity = computeTypeComplexity(F.getReturnType());
+        facts.m_retBytes = computeMarshalingBytes(F.getReturnType(), dataLayout);
+    }
+}
+
+void ModuleFacts::collectBlockFacts(llvm::Module& M,
+                                    const pdg::PDG& pdg,
+                                    const FunctionAnalysesGetter& analysesGetter,
+                                    AnalysedFactsCache& cache)
+{
+    std::unordered_map<llvm::Function*, std::vector<std::pair<llvm::Function*, llvm::CallSite>>> callerCallSites;
+    for (const auto& [F, Fpdg] : pdg.getFunctionPDGs()) {
+        if (!F) {
+            continue;
+        }
+        getMutableFacts(F).m_callSites.reserve(Fpdg->getCallSites().size());
+        for (const auto& callSite : Fpdg->getCallSites()) {
+            callerCallSites[callSite.getCaller()].push_back(std::make_pair(F, callSite));
+        }
+    }
+    std::unordered_map<llvm::Instruction*, unsigned> callSiteTargets;
+    for (const auto& [caller, callSites] : callerCallSites) {
+        for (const auto& [F, callSite] : callSites) {
+            ++callSiteTargets[callSite.getInstruction()];
+        }
+    }
+    unsigned analysedFunctions = 0;
+    // Analyses are requested once per function, as each request recomputes them
+    for (auto& caller : M) {
+        if (caller.isDeclaration()) {
+            continue;
+        }
+        auto cachePos = cache.find(&caller);
+        if (cachePos == cache.end()) {
+            const FunctionAnalyses analyses = analysesGetter(&caller);
+            AnalysedFacts analysed;
+            collectMemoryFacts(&caller, analyses, analysed);
+            collectCodeSize(&caller, analyses, analysed);
+            cachePos = cache.insert(std::make_pair(&caller, std::move(analysed))).first;
+            ++analysedFunctions;
+        }
+        const AnalysedFacts& analysed = cachePos->second;
+        auto& facts = getMutableFacts(&caller);
+        facts.m_codeSize = analysed.m_codeSize;
+        facts.m_memoryOps = analysed.m_memoryOps;
+        m_moduleCodeSize += analysed.m_codeSize;
+        auto blockIt = analysed.m_blocks.begin();
+        for (auto& B : caller) {
+            m_blockFacts.insert(std::make_pair(&B, *blockIt++));
+        }
+        auto callSitesPos = callerCallSites.find(&caller);
+        if (callSitesPos == callerCallSites.end()) {
+            continue;
+        }
+        for (const auto& [F, callSite] : callSitesPos->second) {
+            const auto& block = m_blockFacts.at(callSite.getParent());
+            // Calls through a bitcast of F, e.g. to a prototype declared differently, are direct
+            const bool indirect = callSite.getCalledValue()->stripPointerCasts() != F;
+            double frequency = block.m_frequency;
+            if (indirect) {
+                frequency /= callSiteTargets[callSite.getInstruction()];
+            }
+            getMutableFacts(F).m_callSites.push_back(CallSiteFact{callSite, &caller, block.m_loopDepth, frequency, indirect});
+        }
+    }
+    if (analysedFunctions != cache.size()) {
+        m_logger.info("Analysed " + std::to_string(analysedFunctions) + " functions, reused facts of "
+                      + std::to_string(cache.size() - analysedFunctions) + " unchanged functions");
+    }
+}
+
+void ModuleFacts::collectForbiddenCalls(llvm::Module& M)
+{
+    const auto& libraryCalls = LibraryCalls::get();
+    for (auto& F : M) {
+        if (!libraryCalls.isForbidden(&F)) {
+            continue;
+        }
+        // Call site facts have targets of indirect calls too, use lists give direct calls and calls through casts
+        for (const auto& callSite : getCallSites(&F)) {
+            getMutableFacts(callSite.caller).m_callsForbidden = true;
+        }
+        for (auto* user : F.users()) {
+            if (llvm::isa<llvm::ConstantExpr>(user)) {
+                for (auto* castUser : user->users()) {
+                    llvm::CallSite callSite(castUser);
+                    if (callSite && callSite.getCalledValue() == user) {
+                        getMutableFacts(callSite.getCaller()).m_callsForbidden = true;
+                    }
+                }
+                continue;
+            }
+            llvm::CallSite callSite(user);
+            if (callSite && callSite.getCalledValue() == &F) {
+                getMutableFacts(callSite.getCaller()).m_callsForbidden = true;
+            }
+        }
+    }
+}
+
+void ModuleFacts::collectMemoryFacts(llvm::Function* F, const FunctionAnalyses& analyses, AnalysedFacts& facts)
+{
+    double memoryOps = 0;
+    facts.m_blocks.reserve(F->size());
+    for (auto& B : *F) {
+        unsigned blockMemoryOps = 0;
+        for (auto& I : B) {
+            if (llvm::isa<llvm::LoadInst>(&I) || llvm::isa<llvm::StoreInst>(&I)
+                    || llvm::isa<llvm::AtomicRMWInst>(&I) || llvm::isa<llvm::AtomicCmpXchgInst>(&I)
+                    || llvm::isa<llvm::MemIntrinsic>(&I)) {
+                ++blockMemoryOps;
+            }
+        }
+        BlockFacts blockFacts;
+        if (analyses.loopInfo) {
+            blockFacts.m_loopDepth = analyses.loopInfo->getLoopDepth(&B);
+        }
+        blockFacts.m_frequency = computeBlockFrequency(&B, analyses);
+        blockFacts.m_tripCountsKnown = computeTripCountsKnown(&B, analyses);
+        facts.m_blocks.push_back(blockFacts);
+        memoryOps += blockFacts.m_frequency * blockMemoryOps;
+    }
+    facts.m_memoryOps = memoryOps;
+}
+
+void ModuleFacts::collectCodeSize(llvm::Function* F, const FunctionAnalyses& analyses, AnalysedFacts& facts)
+{
+    long instructions = 0;
+    if (auto* targetTransformInfo = analyses.targetTransformInfo) {
+        // User costs are in units of basic instructions and are 0 for instructions folded away by lowering
+        for (auto& B : *F) {
+            for (auto& I : B) {
+                instructions += targetTransformInfo->getUserCost(&I);
+            }
+        }
+    } else {
+        instructions = getFunctionSize(F);
+    }
+    facts.m_codeSize = FUNCTION_OVERHEAD_BYTES + instructions * INSTRUCTION_BYTES;
+}
+
+double ModuleFacts::computeBlockFrequency(llvm::BasicBlock* block, const FunctionAnalyses& analyses) const
+{
+    auto* blockFrequency = analyses.blockFrequency;
+    if (!blockFrequency || blockFrequency->getEntryFreq() == 0) {
+        return 1;
+    }
+    double frequency = (double) blockFrequency->getBlockFreq(block).getFrequency() / blockFrequency->getEntryFreq();
+    if (!analyses.loopInfo || !analyses.scalarEvolution) {
+        return frequency;
+    }
+    for (auto* loop = analyses.loopInfo->getLoopFor(block); loop; loop = loop->getParentLoop()) {
+        const unsigned tripCount = analyses.scalarEvolution->getSmallConstantTripCount(loop);
+        auto* preheader = loop->getLoopPreheader();
+        if (tripCount == 0 || !preheader) {
+            continue;
+        }
+        const double preheaderFrequency = blockFrequency->getBlockFreq(preheader).getFrequency();
+        const double headerFrequency = blockFrequency->getBlockFreq(loop->getHeader()).getFrequency();
+        if (preheaderFrequency == 0 || headerFrequency == 0) {
+            continue;
+        }
+        // Replace iterations guessed from branch probabilities with the known trip count
+        frequency *= tripCount / (headerFrequency / preheaderFrequency);
+    }
+    return frequency;
+}
+
+bool ModuleFacts::computeTripCountsKnown(llvm::BasicBlock* block, const FunctionAnalyses& analyses) const
+{
+    if (!analyses.loopInfo) {
+        return false;
+    }
+    for (auto* loop = analyses.loopInfo->getLoopFor(block); loop; loop = loop->getParentLoop()) {
+        if (!analyses.scalarEvolution || analyses.scalarEvolution->getSmallConstantTripCount(loop) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ModuleFacts::computeFunctionFrequencies(llvm::Module& M)
+{
+    // Callees of each function, to visit callers before callees
+    std::unordered_map<llvm::Function*, std::vector<llvm::Function*>> callees;
+    for (auto& F : M) {
+        std::unordered_set<llvm::Function*> callers;
+        for (const auto& callSite : getCallSites(&F)) {
+            if (callers.insert(callSite.caller).second) {
+                callees[callSite.caller].push_back(&F);
+            }
+        }
+    }
+    llvm::Function* mainF = M.getFunction("main");
+    std::vector<llvm::Function*> roots;
+    if (mainF) {
+        roots.push_back(mainF);
+    }
+    for (auto& F : M) {
+        if (getCallSites(&F).empty() && &F != mainF) {
+            roots.push_back(&F);
+        }
+    }
+    // Reverse post order, exact in one sweep for acyclic call graphs
+    std::vector<llvm::Function*> order;
+    std::unordered_set<llvm::Function*> visited;
+    std::vector<std::pair<llvm::Function*, unsigned>> stack;
+    const auto& visit = [&] (llvm::Function* root) {
+        if (!visited.insert(root).second) {
+            return;
+        }
+        stack.push_back(std::make_pair(root, 0));
+        while (!stack.empty()) {
+            auto& [F, calleeIdx] = stack.back();
+            const auto& Fcallees = callees[F];
+            if (calleeIdx == Fcallees.size()) {
+                order.push_back(F);
+                stack.pop_back();
+                continue;
+            }
+            llvm::Function* callee = Fcallees[calleeIdx++];
+            if (visited.insert(callee).second) {
+                stack.push_back(std::make_pair(callee, 0));
+            }
+        }
+    };
+    for (auto* root : roots) {
+        visit(root);
+    }
+    // Functions only reachable from cycles
+    for (auto& F : M) {
+        visit(&F);
+    }
+    std::reverse(order.begin(), order.end());
+
+    for (unsigned iteration = 0; iteration < MAX_FREQUENCY_ITERATIONS; ++iteration) {
+        double maxChange = 0;
+        for (auto* F : order) {
+            auto& facts = getMutableFacts(F);
+            double frequency = (F == mainF || facts.m_callSites.empty()) ? 1 : 0;
+            for (const auto& callSite : facts.m_callSites) {
+                frequency += callSite.frequency * getFunctionFrequency(callSite.caller);
+            }
+            frequency = std::min(frequency, MAX_FREQUENCY);
+            maxChange = std::max(maxChange, std::abs(frequency - facts.m_frequency) / std::max(frequency, 1.0));
+            facts.m_frequency = frequency;
+        }
+        if (maxChange < FREQUENCY_EPSILON) {
+            return;
+        }
+    }
+    m_logger.warn("Function frequencies of recursive calls did not converge");
+}
+
+void ModuleFacts::loadAnalysedFacts(llvm::Module& M,
+                                    const std::string& fileName,
+                                    const FunctionHashes& hashes,
+                                    AnalysedFactsCache& cache) const
+{
+    std::ifstream ifs(fileName, std::ifstream::in);
+    if (!ifs.is_open()) {
+        return;
+    }
+    nlohmann::json root;
+    try {
+        ifs >> root;
+        for (auto& F : M) {
+            auto pos = root.find(F.getName().str());
+            if (F.isDeclaration() || pos == root.end() || pos->at("hash").get<std::uint64_t>() != hashes.getHash(&F)) {
+                continue;
+            }
+            const auto& blocks = pos->at("blocks");
+            if (blocks.size() != F.size()) {
+                continue;
+            }
+            AnalysedFacts facts;
+            facts.m_codeSize = pos->at("code_size");
+            facts.m_memoryOps = pos->at("memory_ops");
+            for (const auto& block : blocks) {
+                facts.m_blocks.push_back(BlockFacts{block.at(0).get<unsigned>(), block.at(1).get<double>(), block.at(2).get<bool>()});
+            }
+            cache.insert(std::make_pair(&F, std::move(facts)));
+        }
+    } catch (const nlohmann::json::exception& e) {
+        m_logger.warn("Ignoring malformed module facts file " + fileName);
+        cache.clear();
+    }
+}
+
+void ModuleFacts::saveAnalysedFacts(const std::string& fileName,
+                                    const FunctionHashes& hashes,
+                                    const AnalysedFactsCache& cache) const
+{
+    nlohmann::json root = nlohmann::json::object();
+    for (const auto& [F, facts] : cache) {
+        nlohmann::json& item = root[F->getName().str()];
+        item["hash"] = hashes.getHash(F);
+        item["code_size"] = facts.m_codeSize;
+        item["memory_ops"] = facts.m_memoryOps;
+        item["blocks"] = nlohmann::json::array();
+        for (const auto& block : facts.m_blocks) {
+            item["blocks"].push_back({block.m_loopDepth, block.m_frequency, block.m_tripCountsKnown});
+        }
+    }
+    std::ofstream ofs(fileName);
+    if (!ofs.is_open()) {
+        m_logger.error("Could not open " + fileName + " to save module facts");
+        return;
+    }
+    ofs << root;
+}
+
+const ModuleFacts::FunctionFacts* ModuleFacts::getFacts(llvm::Function* F) const
+{
+    const unsigned id = m_functionIndex.getId(F);
+    return id == ValueIndex<llvm::Function>::INVALID_ID ? nullptr : &m_functionFacts[id];
+}
+
+// F is a function of the module
+ModuleFacts::FunctionFacts& ModuleFacts::getMutableFacts(llvm::Function* F)
+{
+    return m_functionFacts[m_functionIndex.getId(F)];
+}
+
+int ModuleFacts::computeTypeComplexity(llvm::Type* type)
+{
+    if (!type->isAggregateType() && !type->isVectorTy()) {
+        return getTypeComplexity(type);
+    }
+    auto pos = m_typeComplexities.find(type);
+    if (pos != m_typeComplexities.end()) {
+        return pos->second;
+    }
+    const int complexity = getTypeComplexity(type);
+    m_typeComplexities.insert(std::make_pair(type, complexity));
+    return complexity;
+}
+
+long ModuleFacts::computeMarshalingBytes(llvm::Type* type, const llvm::DataLayout& dataLayout)
+{
+    std::unordered_set<llvm::Type*> pointees;
+    std::unordered_map<llvm::Type*, long> truncatedBytes;
+    bool truncated = false;
+    return computeMarshalingBytes(type, dataLayout, pointees, truncatedBytes, truncated);
+}
+
+long ModuleFacts::computeMarshalingBytes(llvm::Type* type,
+                                         const llvm::DataLayout& dataLayout,
+                                         std::unordered_set<llvm::Type*>& pointees,
+                                         std::unordered_map<llvm::Type*, long>& truncatedBytes,
+                                         bool& truncated)
+{
+    auto pos = m_typeBytes.find(type);
+    if (pos != m_typeBytes.end()) {
+        return pos->second;
+    }
+    // Bytes of types reached through recursive pointers depend on where traversal entered,
+    // those are kept for the current traversal only. Types shared by many fields are thus visited once
+    pos = truncatedBytes.find(type);
+    if (pos != truncatedBytes.end()) {
+        truncated = true;
+        return pos->second;
+    }
+    long bytes = 0;
+    bool typeTruncated = false;
+    if (auto* ptrType = llvm::dyn_cast<llvm::PointerType>(type)) {
+        bytes = dataLayout.getPointerSize();
+        llvm::Type* pointee = ptrType->getElementType();
+        if (pointee->isIntegerTy(8)) {
+            bytes += STRING_BYTES;
+        } else if (!pointee->isSized()) {
+            // Function pointers and opaque types, only the pointer is passed
+        } else if (!pointees.insert(pointee).second) {
+            // Recursive type, every object is copied once
+            typeTruncated = true;
+        } else {
+            bytes += computeMarshalingBytes(pointee, dataLayout, pointees, truncatedBytes, typeTruncated);
+            pointees.erase(pointee);
+        }
+    } else if (auto* structType = llvm::dyn_cast<llvm::StructType>(type)) {
+        bytes = structType->isSized() ? dataLayout.getTypeAllocSize(structType) : 0;
+        for (auto it = structType->element_begin(); it != structType->element_end(); ++it) {
+            if ((*it)->isSized()) {
+                bytes += computeMarshalingBytes(*it, dataLayout, pointees, truncatedBytes, typeTruncated) - dataLayout.getTypeAllocSize(*it);
+            }
+        }
+    } else if (auto* arrayType = llvm::dyn_cast<llvm::ArrayType>(type)) {
+        llvm::Type* elementType = arrayType->getElementType();
+        bytes = dataLayout.getTypeAllocSize(arrayType);
+        bytes += arrayType->getNumElements()
+                * (computeMarshalingBytes(elementType, dataLayout, pointees, truncatedBytes, typeTruncated) - dataLayout.getTypeAllocSize(elementType));
+    } else if (type->isSized()) {
+        bytes = dataLayout.getTypeStoreSize(type);
+    }
+    if (typeTruncated) {
+        truncatedBytes.insert(std::make_pair(type, bytes));
+    } else {
+        m_typeBytes.insert(std::make_pair(type, bytes));
+    }
+    truncated |= typeTruncated;
+    return bytes;
+}
+
+} // namespace vazgen
@@ -0,0 +1,130 @@
+#include "Analysis/PDGSnapshot.h"
+
+#include "PDG/PDG/PDG.h"
+#include "PDG/PDG/PDGNode.h"
+#include "PDG/PDG/PDGEdge.h"
+#include "PDG/PDG/PDGLLVMNode.h"
+#include "PDG/PDG/FunctionPDG.h"
+
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Module.h"
+
+namespace vazgen {
+
+PDGSnapshot::PDGSnapshot(llvm::Module& M, const pdg::PDG& pdg, const ValueIndex<llvm::Function>& functionIndex)
+    : m_functionIndex(functionIndex)
+{
+    // Seed with all nodes reachable from PDG maps, in module order. The rest is discovered through edges.
+    for (auto& F : M) {
+        if (!pdg.hasFunctionPDG(&F)) {
+            continue;
+        }
+        auto Fpdg = pdg.getFunctionPDG(&F);
+        for (auto it = Fpdg->llvmNodesBegin(); it != Fpdg->llvmNodesEnd(); ++it) {
+            addNode(it->second.get());
+        }
+        for (auto& arg : F.args()) {
+            if (Fpdg->hasFormalArgNode(&arg)) {
+                addNode(Fpdg->getFormalArgNode(&arg).get());
+            }
+        }
+    }
+    for (auto glob_it = M.global_begin(); glob_it != M.global_end(); ++glob_it) {
+        if (pdg.hasGlobalVariableNode(&*glob_it)) {
+            addNode(pdg.getGlobalVariableNode(&*glob_it).get());
+        }
+    }
+    m_outOffsets.push_back(0);
+    m_inOffsets.push_back(0);
+    // nodes are appended while edges are added, and get their edges in turn
+    for (unsigned id = 0; id < m_nodes.size(); ++id) {
+        addEdges(m_nodes[id]);
+    }
+    m_nodes.clear();
+    m_nodes.shrink_to_fit();
+}
+
+unsigned PDGSnapshot::getNodeId(pdg::PDGNode* node) const
+{
+    auto pos = m_nodeIds.find(node);
+    return pos == m_nodeIds.end() ? INVALID_NODE : pos->second;
+}
+
+unsigned PDGSnapshot::addNode(pdg::PDGNode* node)
+{
+    auto [pos, inserted] = m_nodeIds.insert(std::make_pair(node, m_nodes.size()));
+    if (!inserted) {
+        return pos->second;
+    }
+    m_nodes.push_back(node);
+    NodeKind kind = NON_LLVM;
+    llvm::Value* value = nullptr;
+    llvm::Function* nodeFunction = nullptr;
+    bool isPointerActualArg = false;
+    if (llvm::isa<pdg::PDGNullNode>(node)) {
+        kind = NULL_NODE;
+    } else if (auto* llvmNode = llvm::dyn_cast<pdg::PDGLLVMNode>(node)) {
+        kind = LLVM;
+        value = llvmNode->getNodeValue();
+        if (llvm::isa<pdg::PDGLLVMConstantNode>(llvmNode)) {
+            kind = CONSTANT;
+        } else if (auto* functionNode = llvm::dyn_cast<pdg::PDGLLVMFunctionNode>(llvmNode)) {
+            kind = FUNCTION;
+            nodeFunction = functionNode->getFunction();
+        } else if (auto* formalArgNode = llvm::dyn_cast<pdg::PDGLLVMFormalArgumentNode>(llvmNode)) {
+            kind = FORMAL_ARG;
+            nodeFunction = formalArgNode->getFunction();
+        } else if (auto* actualArgNode = llvm::dyn_cast<pdg::PDGLLVMActualArgumentNode>(llvmNode)) {
+            kind = ACTUAL_ARG;
+            auto callSite = actualArgNode->getCallSite();
+            isPointerActualArg = callSite.getArgOperand(actualArgNode->getArgIndex())->getType()->isPointerTy();
+            m_callSites.insert(std::make_pair(pos->second, callSite.getInstruction()));
+        } else if (llvm::isa<pdg::PDGLLVMInstructionNode>(llvmNode)) {
+            kind = INSTRUCTION;
+        }
+    }
+    m_kinds.push_back(kind);
+    m_values.push_back(value);
+    m_parents.push_back(getFunctionId(node->getParent()));
+    m_nodeFunctions.push_back(getFunctionId(nodeFunction));
+    m_pointerActualArgs.push_back(isPointerActualArg);
+    return pos->second;
+}
+
+void PDGSnapshot::addEdges(pdg::PDGNode* node)
+{
+    std::vector<unsigned> controlEdges;
+    for (auto it = node->outEdgesBegin(); it != node->outEdgesEnd(); ++it) {
+        const unsigned destId = addNode((*it)->getDestination().get());
+        if ((*it)->isControlEdge()) {
+            controlEdges.push_back(destId);
+        } else {
+            m_outEdges.push_back(destId);
+        }
+    }
+    m_outControlOffsets.push_back(m_outEdges.size());
+    m_outEdges.insert(m_outEdges.end(), controlEdges.begin(), controlEdges.end());
+    m_outOffsets.push_back(m_outEdges.size());
+
+    controlEdges.clear();
+    for (auto it = node->inEdgesBegin(); it != node->inEdgesEnd(); ++it) {
+        const unsigned sourceId = addNode((*it)->getSource().get());
+        if ((*it)->isControlEdge()) {
+            controlEdges.push_back(sourceId);
+        } else {
+            m_inEdges.push_back(sourceId);
+        }
+    }
+    m_inControlOffsets.push_back(m_inEdges.size());
+    m_inEdges.insert(m_inEdges.end(), controlEdges.begin(), controlEdges.end());
+    m_inOffsets.push_back(m_inEdges.size());
+}
+
+unsigned PDGSnapshot::getFunctionId(llvm::Function* F) const
+{
+    return F ? m_functionIndex.getId(F) : ValueIndex<llvm::Function>::INVALID_ID;
+}
+
+} // namespace vazgen
+
@@ -1,118 +1,204 @@
 #include "Analysis/Partition.h"
 
+#include "Analysis/ModuleFacts.h"
+
 #include "llvm/IR/Function.h"
 #include "llvm/IR/GlobalVariable.h"
 
 namespace vazgen {
 
+Partition::Partition()
+    : m_data(std::make_shared<Data>())
+{
+}
+
+Partition::Partition(const ModuleFacts& moduleFacts)
+    : m_data(std::make_shared<Data>())
+{
+    m_data->m_partition = FunctionSet(&moduleFacts.getFunctionIndex());
+    m_data->m_inInterface = FunctionSet(&moduleFacts.getFunctionIndex());
+    m_data->m_outInterface = FunctionSet(&moduleFacts.getFunctionIndex());
+    m_data->m_partitionGlobals = GlobalsSet(&moduleFacts.getGlobalsIndex());
+}
+
+void Partition::setInterfaceGraph(InterfaceGraphType graph)
+{
+    auto& data = getMutableData();
+    data.m_interfaceGraph = graph;
+    computeInterfaces(data);
+}
+
+bool Partition::hasInterfaceGraph() const
+{
+    return m_data->m_interfaceGraph != nullptr;
+}
+
 void Partition::setPartition(const FunctionSet& functions)
 {
-    m_partition = functions;
+    auto& data = getMutableData();
+    data.m_partition = functions;
+    computeInterfaces(data);
 }
 
 void Partition::setInInterface(const FunctionSet& functions)
 {
-    m_inInterface = functions;
+    getMutableData().m_inInterface = functions;
 }
 
 void Partition::setOutInterface(const FunctionSet& functions)
 {
-    m_outInterface = functions;
+    getMutableData().m_outInterface = functions;
 }
 
 void Partition::setGlobals(const GlobalsSet& globals)
 {
-    m_partitionGlobals = globals;
+    getMutableData().m_partitionGlobals = globals;
 }
 
 void Partition::setPartition(FunctionSet&& functions)
 {
-    m_partition = std::move(functions);
+    auto& data = getMutableData();
+    data.m_partition = std::move(functions);
+    computeInterfaces(data);
 }
 
 void Partition::setInInterface(FunctionSet&& functions)
 {
-    m_inInterface = std::move(functions);
+    getMutableData().m_inInterface = std::move(functions);
 }
 
 void Partition::setOutInterface(FunctionSet&& functions)
 {
-    m_outInterface = std::move(functions);
+    getMutableData().m_outInterface = std::move(functions);
 }
 
 void Partition::setGlobals(GlobalsSet&& globals)
 {
-    m_partitionGlobals = std::move(globals);
+    getMutableData().m_partitionGlobals = std::move(globals);
 }
 
 void Partition::addToPartition(llvm::Function* F)
 {
-    m_partition.insert(F);
+    if (contains(F)) {
+        return;
+    }
+    const unsigned id = m_data->m_partition.getId(F);
+    // Functions created after ModuleFacts, e.g. global setters, can not be in partitions
+    assert(id != ValueIndex<llvm::Function>::INVALID_ID && "Function is not in the module facts index");
+    if (id == ValueIndex<llvm::Function>::INVALID_ID) {
+        return;
+    }
+    addFunction(getMutableData(), id);
 }
 
 void Partition::addToPartition(const FunctionSet& functions)
 {
-    m_partition.insert(functions.begin(), functions.end());
+    auto& data = getMutableData();
+    if (!data.m_interfaceGraph) {
+        data.m_partition |= functions;
+        return;
+    }
+    FunctionSet newFunctions = functions;
+    newFunctions -= data.m_partition;
+    for (auto it = newFunctions.begin(); it != newFunctions.end(); ++it) {
+        addFunction(data, it.getId());
+    }
 }
 
 void Partition::addToPartition(const Partition& partition)
 {
-    m_partition.insert(partition.m_partition.begin(), partition.m_partition.end());
-    m_inInterface.insert(partition.m_inInterface.begin(), partition.m_inInterface.end());
-    m_outInterface.insert(partition.m_outInterface.begin(), partition.m_outInterface.end());
-    m_partitionGlobals.insert(partition.m_partitionGlobals.begin(), partition.m_partitionGlobals.end());
+    if (m_data == partition.m_data) {
+        return;
+    }
+    addToPartition(partition.m_data->m_partition);
+    auto& data = getMutableData();
+    if (!data.m_interfaceGraph) {
+        data.m_inInterface |= partition.m_data->m_inInterface;
+        data.m_outInterface |= partition.m_data->m_outInterface;
+    }
+    data.m_partitionGlobals |= partition.m_data->m_partitionGlobals;
     addRelatedFunctions(partition);
 }
 
 void Partition::addRelatedFunction(llvm::Function* F, int level)
 {
-    m_relatedFunctions.insert(std::make_pair(F, level));
+    if (m_data->m_relatedFunctions.find(F) != m_data->m_relatedFunctions.end()) {
+        return;
+    }
+    getMutableData().m_relatedFunctions.insert(std::make_pair(F, level));
 }
 
 void Partition::removeFromPartition(llvm::Function* F)
 {
-    m_partition.erase(F);
+    if (!contains(F)) {
+        return;
+    }
+    auto& data = getMutableData();
+    removeFunction(data, data.m_partition.getId(F));
+}
+
+void Partition::removeFromPartition(const FunctionSet& functions)
+{
+    if (!m_data->m_partition.intersects(functions)) {
+        return;
+    }
+    auto& data = getMutableData();
+    if (!data.m_interfaceGraph) {
+        data.m_partition -= functions;
+        return;
+    }
+    FunctionSet removedFunctions = functions;
+    removedFunctions &= data.m_partition;
+    for (auto it = removedFunctions.begin(); it != removedFunctions.end(); ++it) {
+        removeFunction(data, it.getId());
+    }
 }
 
 void Partition::removeRelatedFunction(llvm::Function* F)
 {
-    m_relatedFunctions.erase(F);
+    if (m_data->m_relatedFunctions.find(F) == m_data->m_relatedFunctions.end()) {
+        return;
+    }
+    getMutableData().m_relatedFunctions.erase(F);
 }
 
 void Partition::clearRelatedFunctions()
 {
-    m_relatedFunctions.clear();
+    if (m_data->m_relatedFunctions.empty()) {
+        return;
+    }
+    getMutableData().m_relatedFunctions.clear();
 }
 
 const Partition::FunctionSet& Partition::getPartition() const
 {
-    return m_partition;
+    return m_data->m_partition;
 }
 
 const Partition::FunctionSet& Partition::getInInterface() const
 {
-    return m_inInterface;
+    return m_data->m_inInterface;
 }
 
 const Partition::FunctionSet& Partition::getOutInterface() const
 {
-    return m_outInterface;
+    return m_data->m_outInterface;
 }
 
 const Partition::GlobalsSet& Partition::getGlobals() const
 {
-    return m_partitionGlobals;
+    return m_data->m_partitionGlobals;
 }
 
-const std::unordered_map<llvm::Function*, int> Partition::getRelatedFunctions() const
+const Partition::RelatedFunctions& Partition::getRelatedFunctions() const
 {
-    return m_relatedFunctions;
+    return m_data->m_relatedFunctions;
 }
 
 int Partition::getFunctionRelationLevel(llvm::Function* F) const
 {
-    auto pos = m_relatedFunctions.find(F);
-    if (pos == m_relatedFunctions.end()) {
+    auto pos = m_data->m_relatedFunctions.find(F);
+    if (pos == m_data->m_relatedFunctions.end()) {
         return -1;
     }
     return pos->second;
@@ -120,12 +206,12 @@ int Partition::getFunctionRelationLevel(llvm::Function* F) const
 
 bool Partition::contains(llvm::Function* F) const
 {
-    return m_partition.find(F) != m_partition.end();
+    return m_data->m_partition.contains(F);
 }
 
 bool Partition::containsFunctionWithName(const std::string& Fname) const
 {
-    for (const auto& F : m_partition) {
+    for (const auto& F : m_data->m_partition) {
         if (F->getName() == Fname) {
             return true;
         }
@@ -135,19 +221,111 @@ bool Partition::containsFunctionWithName(const std::string& Fname) const
 
 bool Partition::contains(llvm::GlobalVariable* g) const
 {
-    return m_partitionGlobals.find(g) != m_partitionGlobals.end();
+    return m_data->m_partitionGlobals.contains(g);
 }
 
 bool Partition::references(llvm::GlobalVariable* global) const
 {
-    return m_partitionGlobals.find(global) != m_partitionGlobals.end();
+    return m_data->m_partitionGlobals.contains(global);
+}
+
+Partition::Data& Partition::getMutableData()
+{
+    if (m_data.use_count() > 1) {
+        m_data = std::make_shared<Data>(*m_data);
+    }
+    return *m_data;
+}
+
+void Partition::computeInterfaces(Data& data)
+{
+    const auto& graph = data.m_interfaceGraph;
+    if (!graph) {
+        return;
+    }
+    const unsigned size = graph->getFunctionIndex().size();
+    data.m_outsideCallers.assign(size, 0);
+    data.m_insideCallers.assign(size, 0);
+    for (unsigned callerId = 0; callerId < graph->size(); ++callerId) {
+        if (data.m_partition.containsId(callerId)) {
+            for (auto calleeId : graph->getOutInterfaceEdges(callerId)) {
+                ++data.m_insideCallers[calleeId];
+            }
+        } else {
+            for (auto calleeId : graph->getInInterfaceEdges(callerId)) {
+                ++data.m_outsideCallers[calleeId];
+            }
+        }
+    }
+    data.m_inInterface.clear();
+    data.m_outInterface.clear();
+    for (unsigned id = 0; id < size; ++id) {
+        updateInterfaces(data, id);
+    }
+}
+
+void Partition::addFunction(Data& data, unsigned id)
+{
+    data.m_partition.insertId(id);
+    if (data.m_interfaceGraph) {
+        updateCallers(data, id, 1);
+    }
+}
+
+void Partition::removeFunction(Data& data, unsigned id)
+{
+    data.m_partition.eraseId(id);
+    if (data.m_interfaceGraph) {
+        updateCallers(data, id, -1);
+    }
+}
+
+// delta is 1 when function with given id has been added to the partition and -1 when it has been removed
+void Partition::updateCallers(Data& data, unsigned id, int delta)
+{
+    const auto& inEdges = data.m_interfaceGraph->getInInterfaceEdges(id);
+    const auto& outEdges = data.m_interfaceGraph->getOutInterfaceEdges(id);
+    for (auto calleeId : inEdges) {
+        data.m_outsideCallers[calleeId] -= delta;
+    }
+    for (auto calleeId : outEdges) {
+        data.m_insideCallers[calleeId] += delta;
+    }
+    updateInterfaces(data, id);
+    for (auto calleeId : inEdges) {
+        updateInterfaces(data, calleeId);
+    }
+    for (auto calleeId : outEdges) {
+        updateInterfaces(data, calleeId);
+    }
+}
+
+void Partition::updateInterfaces(Data& data, unsigned id)
+{
+    const bool inPartition = data.m_partition.containsId(id);
+    const bool hasOutsideCallers = id < data.m_outsideCallers.size() && data.m_outsideCallers[id] > 0;
+    const bool hasInsideCallers = id < data.m_insideCallers.size() && data.m_insideCallers[id] > 0;
+    if (inPartition && hasOutsideCallers) {
+        data.m_inInterface.insertId(id);
+    } else {
+        data.m_inInterface.eraseId(id);
+    }
+    if (!inPartition && hasInsideCallers) {
+        data.m_outInterface.insertId(id);
+    } else {
+        data.m_outInterface.eraseId(id);
+    }
 }
 
 void Partition::addRelatedFunctions(const Partition& partition)
 {
     const auto& relatedFunctions = partition.getRelatedFunctions();
+    if (relatedFunctions.empty()) {
+        return;
+    }
+    auto& data = getMutableData();
     for (const auto& [function, level] : relatedFunctions) {
-        auto [pair, inserted] = m_relatedFunctions.insert(std::make_pair(function, level));
+        auto [pair, inserted] = data.m_relatedFunctions.insert(std::make_pair(function, level));
         if (!inserted) {
             pair->second = std::min(pair->second, level);
         }
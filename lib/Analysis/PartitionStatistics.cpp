@@ -1,8 +1,9 @@
 #include "Analysis/PartitionStatistics.h"
 
 #include "Analysis/CallGraph.h"
+#include "Analysis/LibraryCalls.h"
+#include "Analysis/ModuleFacts.h"
 #include "Analysis/Partition.h"
-#include "Utils/Utils.h"
 
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Function.h"
@@ -10,25 +11,23 @@
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <set>
+
 namespace vazgen {
 
 PartitionStatistics::PartitionStatistics(std::ofstream& strm,
                                          const Partition& securePartition,
                                          const Partition& insecurePartition,
                                          const CallGraph& callgraph,
+                                         const ModuleFacts& moduleFacts,
                                          llvm::Module& M)
     : Statistics(strm, Statistics::JSON)
     , m_securePartition(securePartition)
     , m_insecurePartition(insecurePartition)
     , m_callgraph(callgraph)
+    , m_moduleFacts(moduleFacts)
     , m_module(M)
-    , m_moduleSize(0)
 {
-    for (auto& F : m_module) {
-        if (!F.isDeclaration()) {
-            m_moduleSize += Utils::getFunctionSize(&F);
-        }
-    }
 }
 
 void PartitionStatistics::report()
@@ -50,6 +49,10 @@ void PartitionStatistics::report(const Partition& partition)
     reportNumOfContextSwitches(partition);
     reportSizeOfTCB(partition);
     repotArgsPassedAccrossPartition(partition);
+    reportMarshaledBytes(partition);
+    if (&partition == &m_securePartition) {
+        reportLibraryCalls(partition);
+    }
 }
 
 void PartitionStatistics::reportPartitionFunctions(const Partition& partition)
@@ -124,15 +127,20 @@ void PartitionStatistics::reportNumOfContextSwitches(const Partition& partition)
 void PartitionStatistics::reportSizeOfTCB(const Partition& partition)
 {
     long tcbSize = 0;
+    long tcbBytes = 0;
     for (const auto& F : partition.getPartition()) {
         if (!m_callgraph.hasFunctionNode(F)) {
             continue;
         }
-        tcbSize += Utils::getFunctionSize(F);
+        tcbSize += m_moduleFacts.getFunctionSize(F);
+        tcbBytes += m_moduleFacts.getCodeSize(F);
     }
-    double tcb_portion = (tcbSize * 100.0) / m_moduleSize;
+    double tcb_portion = (tcbSize * 100.0) / m_moduleFacts.getModuleSize();
     write_entry({"partition", m_partitionName, "TCB"}, (double) tcbSize);
     write_entry({"partition", m_partitionName, "TCB%"}, (double) tcb_portion);
+    double tcb_bytes_portion = (tcbBytes * 100.0) / m_moduleFacts.getModuleCodeSize();
+    write_entry({"partition", m_partitionName, "TCB_bytes"}, (double) tcbBytes);
+    write_entry({"partition", m_partitionName, "TCB_bytes%"}, (double) tcb_bytes_portion);
 }
 
 void PartitionStatistics::repotArgsPassedAccrossPartition(const Partition& partition)
@@ -144,6 +152,60 @@ void PartitionStatistics::repotArgsPassedAccrossPartition(const Partition& parti
     write_entry({"partition", m_partitionName, "args_passed"}, (double) argNum);
 }
 
+void PartitionStatistics::reportMarshaledBytes(const Partition& partition)
+{
+    // Edge weights are normalized, estimates are taken from module facts
+    double calls = 0;
+    double bytes = 0;
+    for (const auto& F : partition.getPartition()) {
+        if (!m_callgraph.hasFunctionNode(F) || LibraryCalls::get().isEnclaveSafe(F)) {
+            continue;
+        }
+        const long callBytes = m_moduleFacts.getArgBytes(F) + m_moduleFacts.getReturnBytes(F);
+        auto Fnode = m_callgraph.getFunctionNode(F);
+        for (auto it = Fnode->inEdgesBegin(); it != Fnode->inEdgesEnd(); ++it) {
+            auto* sourceF = it->getSource()->getFunction();
+            if (partition.contains(sourceF)) {
+                continue;
+            }
+            const double callNum = m_moduleFacts.getCallFrequency(F, sourceF);
+            calls += callNum;
+            bytes += callNum * callBytes;
+        }
+    }
+    write_entry({"partition", m_partitionName, "marshaled_bytes"}, bytes);
+    write_entry({"partition", m_partitionName, "marshaled_bytes_per_call"}, calls == 0 ? 0.0 : bytes / calls);
+}
+
+void PartitionStatistics::reportLibraryCalls(const Partition& partition)
+{
+    // Enclave safe functions are called in place, so they are not reported
+    const auto& libraryCalls = LibraryCalls::get();
+    std::set<std::string> ocallFunctions;
+    std::set<std::string> forbiddenFunctions;
+    for (const auto& F : partition.getPartition()) {
+        if (!m_callgraph.hasFunctionNode(F) || F->isDeclaration()) {
+            continue;
+        }
+        auto Fnode = m_callgraph.getFunctionNode(F);
+        for (auto it = Fnode->outEdgesBegin(); it != Fnode->outEdgesEnd(); ++it) {
+            auto* sinkF = it->getSink()->getFunction();
+            if (!sinkF->isDeclaration()) {
+                continue;
+            }
+            if (libraryCalls.isForbidden(sinkF)) {
+                forbiddenFunctions.insert(sinkF->getName().str());
+            } else if (!libraryCalls.isEnclaveSafe(sinkF)) {
+                ocallFunctions.insert(sinkF->getName().str());
+            }
+        }
+    }
+    write_entry({"partition", m_partitionName, "library_ocalls"},
+                std::vector<std::string>(ocallFunctions.begin(), ocallFunctions.end()));
+    write_entry({"partition", m_partitionName, "forbidden_calls"},
+                std::vector<std::string>(forbiddenFunctions.begin(), forbiddenFunctions.end()));
+}
+
 Double PartitionStatistics::getCtxSwitchesInFunction(llvm::Function* F, const Partition& partition)
 {
     Double ctxSwitchN = 0;
@@ -1,8 +1,13 @@
 #include "Analysis/Partitioner.h"
 
+#include "Analysis/ModuleFacts.h"
+#include "Analysis/PDGSnapshot.h"
+#include "Analysis/SensitivityPropagation.h"
+#include "Analysis/SliceSummaries.h"
 #include "Utils/PartitionUtils.h"
 #include "Utils/Annotation.h"
 #include "Utils/Logger.h"
+#include "Utils/RingBuffer.h"
 #include "Utils/Utils.h"
 
 #include "PDG/PDG/PDG.h"
@@ -13,17 +18,33 @@
 #include "llvm/IR/Function.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Constants.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
 
-#include <list>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+llvm::cl::opt<std::string> Slicer(
+    "slicer",
+    llvm::cl::desc("PDG slicing for annotations: per-annotation (default), bit-parallel or context-sensitive"),
+    llvm::cl::value_desc("slicer name"));
+
+llvm::cl::opt<bool> ReportSlicingReduction(
+    "report-slicing-reduction",
+    llvm::cl::desc("With context-sensitive slicer, compare related functions and TCB with context insensitive slicing"),
+    llvm::cl::value_desc("flag to report slicing reduction"));
 
 namespace vazgen {
 
 namespace {
 
 template <typename Collection>
-void collectFunctionReturnNodes(llvm::Function* F, const pdg::FunctionPDG& f_pdg, Collection& returns)
+void collectFunctionReturnNodes(llvm::Function* F,
+                                const pdg::FunctionPDG& f_pdg,
+                                const PDGSnapshot& snapshot,
+                                Collection& returns)
 {
     for (auto& B : *F) {
         for (auto& I : B) {
@@ -31,7 +52,7 @@ void collectFunctionReturnNodes(llvm::Function* F, const pdg::FunctionPDG& f_pdg
                 if (!f_pdg.hasNode(&I)) {
                     continue;
                 }
-                returns.push_back(f_pdg.getNode(&I));
+                returns.push_back(snapshot.getNodeId(f_pdg.getNode(&I).get()));
             }
         }
     }
@@ -66,11 +87,15 @@ public:
 public:
     PartitionForAnnotation(llvm::Module& M,
                            PDGType pdg,
+                           SliceSummaries* summaries,
                            const Annotation& annotation,
+                           const ModuleFacts& moduleFacts,
                            Logger& logger)
         : m_module(M)
         , m_annotation(annotation)
         , m_pdg(pdg)
+        , m_summaries(summaries)
+        , m_partition(moduleFacts)
         , m_logger(logger)
     {
     }
@@ -82,26 +107,27 @@ protected:
     virtual bool canPartition() const = 0;
     virtual void traverse() = 0;
 
-    void updateFunctionLevel(llvm::Function* currentF, llvm::Function* newF);
-    void addRelatedFunction(llvm::Function* F);
-    bool canProcessNode(pdg::FunctionPDG::PDGNodeTy node) const;
+    void addSummary(const SliceSummary& summary);
+    // Levels are distances from annotated function over function edges of the summaries
+    void addRelatedFunctions();
 
 protected:
     llvm::Module& m_module;
     const Annotation& m_annotation;
     PDGType m_pdg;
+    SliceSummaries* m_summaries;
     Partition m_partition;
     Logger& m_logger;
-    using FunctionLevels = std::unordered_map<llvm::Function*, int>;
-    FunctionLevels m_functionLevels;
+    std::unordered_set<llvm::Function*> m_relatedFunctions;
+    std::unordered_map<llvm::Function*, std::vector<llvm::Function*>> m_functionEdges;
 }; // PartitionForAnnotation
 
 /// Implementation of ProgramPartition for annotated function
 class PartitionForFunction : public PartitionForAnnotation
 {
 public:
-    PartitionForFunction(llvm::Module& M, const Annotation& annotation, Logger& logger)
-        : PartitionForAnnotation(M, PDGType(), annotation, logger)
+    PartitionForFunction(llvm::Module& M, const Annotation& annotation, const ModuleFacts& moduleFacts, Logger& logger)
+        : PartitionForAnnotation(M, PDGType(), nullptr, annotation, moduleFacts, logger)
     {
     }
 
@@ -126,8 +152,10 @@ public:
     PartitionForArguments(llvm::Module& M,
                           const Annotation& annotation,
                           PDGType pdg,
+                          SliceSummaries& summaries,
+                          const ModuleFacts& moduleFacts,
                           Logger& logger)
-        : PartitionForAnnotation(M, pdg, annotation, logger)
+        : PartitionForAnnotation(M, pdg, &summaries, annotation, moduleFacts, logger)
     {
     }
 
@@ -136,16 +164,6 @@ private:
     virtual void traverse() final;
 
     void traverseForArgument(llvm::Argument* arg);
-
-    template <typename Container>
-    void traverseForward(pdg::FunctionPDG::PDGNodeTy formalArgNode, Container& result);
-
-    template <typename Container>
-    void traverseBackward(Container& workingList);
-
-    template <typename Container>
-    void collectNodesForActualArg(pdg::PDGLLVMActualArgumentNode& actualArgNode, Container& forwardWorkingList);
-
 }; // class PartitionForArguments
 
 /// Implementation of ProgramPartition for annotated function and arguments
@@ -155,8 +173,10 @@ public:
     PartitionForReturnValue(llvm::Module& M,
                             const Annotation& annotation,
                             PDGType pdg,
+                            SliceSummaries& summaries,
+                            const ModuleFacts& moduleFacts,
                             Logger& logger)
-        : PartitionForAnnotation(M, pdg, annotation, logger)
+        : PartitionForAnnotation(M, pdg, &summaries, annotation, moduleFacts, logger)
     {
     }
 
@@ -165,6 +185,7 @@ private:
     virtual void traverse() final;
 }; // class PartitionForArguments
 
+/// Finds globals referenced by secure and insecure partitions in a single pass over global nodes
 class PartitionGlobals
 {
 public:
@@ -172,29 +193,48 @@ public:
 
     PartitionGlobals(llvm::Module& module,
                      PDGType pdg,
-                     const Partition& partition,
+                     const Partition& securePartition,
+                     const Partition& insecurePartition,
+                     const ModuleFacts& moduleFacts,
                      Logger& logger)
         : m_module(module)
         , m_pdg(pdg)
-        , m_partition(partition)
+        , m_securePartition(securePartition)
+        , m_insecurePartition(insecurePartition)
         , m_logger(logger)
+        , m_secureGlobals(&moduleFacts.getGlobalsIndex())
+        , m_insecureGlobals(&moduleFacts.getGlobalsIndex())
     {
     }
 
 public:
     void partition();
 
-    const Partition::GlobalsSet& getReferencedGlobals() const
+    const Partition::GlobalsSet& getSecureGlobals() const
+    {
+        return m_secureGlobals;
+    }
+
+    const Partition::GlobalsSet& getInsecureGlobals() const
     {
-        return m_referencedGlobals;
+        return m_insecureGlobals;
     }
 
+private:
+    void partition(llvm::GlobalVariable* global,
+                   pdg::PDGNode* globalNode,
+                   Partition::GlobalsSet& secureGlobals,
+                   Partition::GlobalsSet& insecureGlobals) const;
+    void addReference(llvm::Function* F, bool& secureRef, bool& insecureRef) const;
+
 private:
     llvm::Module& m_module;
     PDGType m_pdg;
-    const Partition& m_partition;
+    const Partition& m_securePartition;
+    const Partition& m_insecurePartition;
     Logger& m_logger;
-    Partition::GlobalsSet m_referencedGlobals;
+    Partition::GlobalsSet m_secureGlobals;
+    Partition::GlobalsSet m_insecureGlobals;
 }; // class PartitionGlobals
 
 Partition PartitionForAnnotation::partition()
@@ -203,48 +243,51 @@ Partition PartitionForAnnotation::partition()
         return m_partition;
     }
     traverse();
+    addRelatedFunctions();
     return m_partition;
 }
 
-void PartitionForAnnotation::updateFunctionLevel(llvm::Function* currentF, llvm::Function* newF)
+void PartitionForAnnotation::addSummary(const SliceSummary& summary)
 {
-    if (!newF) {
-        //m_logger.error("New function is null");
-        return;
-    }
-    if (!currentF) {
-        //m_logger.error("Current function is null");
-        return;
-    }
-    auto pos = m_functionLevels.find(currentF);
-    if (pos == m_functionLevels.end()) {
-        m_logger.error("No entry for current parent " + currentF->getName().str());
-        return;
+    for (auto* F : summary.reachedFunctions) {
+        if (F != m_annotation.getFunction()) {
+            m_relatedFunctions.insert(F);
+        }
     }
-    int level = (newF == currentF) ? pos->second : pos->second + 1;
-    auto [insert_pos, inserted] = m_functionLevels.insert(std::make_pair(newF, level));
-    if (!inserted) {
-        insert_pos->second = std::min(level, insert_pos->second);
+    m_relatedFunctions.insert(summary.calledFunctions.begin(), summary.calledFunctions.end());
+    for (const auto& [from, to] : summary.functionEdges) {
+        m_functionEdges[from].push_back(to);
     }
 }
 
-void PartitionForAnnotation::addRelatedFunction(llvm::Function* F)
+void PartitionForAnnotation::addRelatedFunctions()
 {
-    auto level = m_functionLevels.find(F);
-    if (level == m_functionLevels.end()) {
-        m_logger.error("No level for function " + F->getName().str());
-        assert(false);
-    } else {
+    if (m_relatedFunctions.empty()) {
+        return;
+    }
+    std::unordered_map<llvm::Function*, int> levels;
+    RingBuffer<llvm::Function*> workingList;
+    levels.insert(std::make_pair(m_annotation.getFunction(), 0));
+    workingList.push(m_annotation.getFunction());
+    while (!workingList.empty()) {
+        auto* currentF = workingList.pop();
+        const int level = levels[currentF];
+        for (auto* F : m_functionEdges[currentF]) {
+            if (levels.insert(std::make_pair(F, level + 1)).second) {
+                workingList.push(F);
+            }
+        }
+    }
+    for (auto* F : m_relatedFunctions) {
+        auto level = levels.find(F);
+        if (level == levels.end()) {
+            m_logger.error("No level for function " + F->getName().str());
+            continue;
+        }
         m_partition.addRelatedFunction(F, level->second);
     }
 }
 
-bool PartitionForAnnotation::canProcessNode(pdg::FunctionPDG::PDGNodeTy node) const
-{
-    return !llvm::isa<pdg::PDGLLVMConstantNode>(node.get())
-        && !llvm::isa<pdg::PDGNullNode>(node.get());
-}
-
 bool PartitionForArguments::canPartition() const
 {
     if (!m_annotation.hasAnnotatedArguments()) {
@@ -285,149 +328,21 @@ void PartitionForArguments::traverseForArgument(llvm::Argument* arg)
     if (!Fpdg->hasFormalArgNode(arg)) {
         return;
     }
-    std::list<pdg::FunctionPDG::PDGNodeTy> backwardWorkingList;
-    auto formalArgNode = Fpdg->getFormalArgNode(arg);
-    traverseForward(formalArgNode, backwardWorkingList);
-    traverseBackward(backwardWorkingList);
-}
-
-template <typename Container>
-void PartitionForArguments::traverseForward(pdg::FunctionPDG::PDGNodeTy formalArgNode,
-                                            Container& result)
-{
-    auto Fpdg = m_pdg->getFunctionPDG(m_annotation.getFunction());
-    m_functionLevels.insert(std::make_pair(formalArgNode->getParent(), 0));
-    std::list<pdg::FunctionPDG::PDGNodeTy> forwardWorkingList;
-    std::unordered_set<llvm::Value*> processed_values;
-    forwardWorkingList.push_back(formalArgNode);
-    pdg::PDGNode* currentNode = nullptr;
-
-    while (!forwardWorkingList.empty()) {
-        currentNode = forwardWorkingList.back().get();
-        forwardWorkingList.pop_back();
-        auto* llvmNode = llvm::dyn_cast<pdg::PDGLLVMNode>(currentNode);
-        if (!llvmNode) {
-            continue;
-        }
-        auto* nodeValue = llvmNode->getNodeValue();
-        if (!nodeValue) {
-            continue;
-        }
-        //llvm::dbgs() << "   Node value " << *nodeValue << "\n";
-        // TODO: check this
-        if (llvm::isa<pdg::PDGLLVMInstructionNode>(llvmNode)) {
-            if (!processed_values.insert(nodeValue).second) {
-                continue;
-            }
-        }
-        if (auto* FNode = llvm::dyn_cast<pdg::PDGLLVMFunctionNode>(llvmNode)) {
-            auto* F = FNode->getFunction(); 
-            if (!F->isDeclaration()) {
-                if (F == m_annotation.getFunction()) {
-                    continue;
-                }
-                addRelatedFunction(F);
-            }
-            // Stop traversal here
-            // TODO: should we stop here or continue for other function calls?
-            // i.e. find the formal argument for this call site and continue traversal for it.
-            continue;
-        }
-        if (auto* actualArgNode = llvm::dyn_cast<pdg::PDGLLVMActualArgumentNode>(llvmNode)) {
-            collectNodesForActualArg(*actualArgNode, forwardWorkingList);
-        }
-        if (auto* storeInst = llvm::dyn_cast<llvm::StoreInst>(nodeValue)) {
-            auto valueOp = storeInst->getValueOperand();
-            if (Fpdg->hasNode(valueOp)) {
-                result.push_back(Fpdg->getNode(valueOp));
-            }
-        }
-        auto* currentParent = currentNode->getParent();
-        for (auto out_it = currentNode->outEdgesBegin();
-                out_it != currentNode->outEdgesEnd();
-                ++out_it) {
-            auto destNode = (*out_it)->getDestination();
-            if (!canProcessNode(destNode)) {
-                continue;
-            }
-            forwardWorkingList.push_front(destNode);
-            updateFunctionLevel(currentParent, destNode->getParent());
-        }
+    const auto& pdgSnapshot = m_summaries->getPDGSnapshot();
+    const unsigned formalArgNode = pdgSnapshot.getNodeId(Fpdg->getFormalArgNode(arg).get());
+    if (formalArgNode == PDGSnapshot::INVALID_NODE) {
+        return;
     }
-}
-
-template <typename Container>
-void PartitionForArguments::traverseBackward(Container& workingList)
-{
-    std::unordered_set<llvm::Value*> processed_values;
-    pdg::PDGNode* currentNode = nullptr;
-    while (!workingList.empty()) {
-        currentNode = workingList.back().get();
-        workingList.pop_back();
-        auto* llvmNode = llvm::dyn_cast<pdg::PDGLLVMNode>(currentNode);
-        if (!llvmNode) {
-            continue;
-        }
-        auto* nodeValue = llvmNode->getNodeValue();
-        if (!nodeValue) {
+    auto forwardSummary = m_summaries->getSummary(formalArgNode, SliceSummaries::FORWARD);
+    addSummary(*forwardSummary);
+    // Values stored to the argument are traced back
+    for (auto* value : forwardSummary->storedValues) {
+        if (!Fpdg->hasNode(value)) {
             continue;
         }
-        // TODO: check this
-        if (llvm::isa<pdg::PDGLLVMInstructionNode>(llvmNode)) {
-            if (!processed_values.insert(nodeValue).second) {
-                continue;
-            }
-        }
-        //llvm::dbgs() << "Node value " << *nodeValue << "\n";
-        if (auto* FNode = llvm::dyn_cast<pdg::PDGLLVMFunctionNode>(llvmNode)) {
-            auto* F = FNode->getFunction(); 
-            if (F == m_annotation.getFunction()) {
-                continue;
-            }
-            if (!F->isDeclaration()) {
-                addRelatedFunction(F);
-            }
-            // Stop traversal here
-            continue;
-        }
-        auto* currentParent = currentNode->getParent();
-        for (auto in_it = currentNode->inEdgesBegin();
-                in_it != currentNode->inEdgesEnd();
-                ++in_it) {
-            auto sourceNode = (*in_it)->getSource();
-            if (!canProcessNode(sourceNode)) {
-                continue;
-            }
-            //llvm::dbgs() << "source node " << sourceNode->getNodeAsString() << "\n";
-            workingList.push_front(sourceNode);
-            updateFunctionLevel(currentParent, sourceNode->getParent());
-        }
-    }
-}
-
-template <typename Container>
-void PartitionForArguments::collectNodesForActualArg(pdg::PDGLLVMActualArgumentNode& actualArgNode,
-                                                     Container& forwardWorkingList)
-{
-    auto* arg = actualArgNode.getCallSite().getArgOperand(actualArgNode.getArgIndex());
-    if (!arg->getType()->isPointerTy()) {
-        return;
-    }
-    const int argIdx = actualArgNode.getArgIndex();
-
-    llvm::Function* currentF = actualArgNode.getParent();
-    for (auto it = actualArgNode.outEdgesBegin(); it != actualArgNode.outEdgesEnd(); ++it) {
-        auto destNode = (*it)->getDestination();
-        if (auto* formalArgNode = llvm::dyn_cast<pdg::PDGLLVMFormalArgumentNode>(destNode.get())) {
-            llvm::Function* F = formalArgNode->getFunction();
-            if (!m_pdg->hasFunctionPDG(F)) {
-                continue;
-            }
-            if (!F->isDeclaration()) {
-                updateFunctionLevel(currentF, F);
-                addRelatedFunction(F);
-            }
-            forwardWorkingList.push_front(destNode);
+        const unsigned valueNode = pdgSnapshot.getNodeId(Fpdg->getNode(value).get());
+        if (valueNode != PDGSnapshot::INVALID_NODE) {
+            addSummary(*m_summaries->getSummary(valueNode, SliceSummaries::BACKWARD));
         }
     }
 }
@@ -449,54 +364,17 @@ bool PartitionForReturnValue::canPartition() const
 
 void PartitionForReturnValue::traverse()
 {
-    m_logger.info("Analyzing for annotated return values");
-    llvm::dbgs() << "FUNCTION " << m_annotation.getFunction()->getName() << "\n";
+    m_logger.info("Analyzing for annotated return values of " + m_annotation.getFunction()->getName().str());
     // TODO: do we need to include new functions in the curse of backward traversal?
     llvm::Function* F = m_annotation.getFunction();
-    m_functionLevels.insert(std::make_pair(F, 0));
     auto Fpdg = m_pdg->getFunctionPDG(F);
     m_partition.addToPartition(F);
 
-    std::list<pdg::FunctionPDG::PDGNodeTy> workingList;
-    collectFunctionReturnNodes(F, *Fpdg, workingList);
-    std::unordered_set<llvm::Value*> processed_values;
-
-    pdg::PDGNode* currentNode = nullptr;
-    while (!workingList.empty()) {
-        currentNode = workingList.back().get();
-        workingList.pop_back();
-        auto* llvmNode = llvm::dyn_cast<pdg::PDGLLVMNode>(currentNode);
-        if (!llvmNode) {
-            continue;
-        }
-        auto* nodeValue = llvmNode->getNodeValue();
-        // TODO: check this
-        if (nodeValue) {
-            //llvm::dbgs() << "Node value " << *nodeValue << "\n";
-            if (!processed_values.insert(nodeValue).second) {
-                continue;
-            }
-        }
-        if (auto* FNode = llvm::dyn_cast<pdg::PDGLLVMFunctionNode>(llvmNode)) {
-            llvm::Function* F = FNode->getFunction();
-            if (F == m_annotation.getFunction()) {
-                continue;
-            }
-            if (!F->isDeclaration()) {
-                addRelatedFunction(F);
-            }
-            continue;
-        }
-        auto* currentParent = currentNode->getParent();
-        for (auto in_it = currentNode->inEdgesBegin();
-                in_it != currentNode->inEdgesEnd();
-                ++in_it) {
-            auto sourceNode = (*in_it)->getSource();
-            if (!canProcessNode(sourceNode)) {
-                continue;
-            }
-            workingList.push_front(sourceNode);
-            updateFunctionLevel(currentParent, sourceNode->getParent());
+    std::vector<unsigned> returnNodes;
+    collectFunctionReturnNodes(F, *Fpdg, m_summaries->getPDGSnapshot(), returnNodes);
+    for (auto returnNode : returnNodes) {
+        if (returnNode != PDGSnapshot::INVALID_NODE) {
+            addSummary(*m_summaries->getSummary(returnNode, SliceSummaries::RETURN_BACKWARD));
         }
     }
 }
@@ -504,68 +382,191 @@ void PartitionForReturnValue::traverse()
 void PartitionGlobals::partition()
 {
     m_logger.info("Analyzing for globals");
+    // Global nodes are looked up here, in module order, so that workers only read shared data
+    std::vector<std::pair<llvm::GlobalVariable*, pdg::PDGNode*>> globals;
     for (auto glob_it = m_module.global_begin();
          glob_it != m_module.global_end();
          ++glob_it) {
-         assert(m_pdg->hasGlobalVariableNode(&*glob_it));
-         const auto& globalNode = m_pdg->getGlobalVariableNode(&*glob_it);
-         for (auto in_it = globalNode->inEdgesBegin();
-              in_it != globalNode->inEdgesEnd();
-              ++in_it) {
-             if (!m_partition.contains(Utils::getNodeParent((*in_it)->getSource().get()))) {
-                 continue;
-             }
-             m_referencedGlobals.insert(&*glob_it);
-         }
-         for (auto out_it = globalNode->outEdgesBegin();
-              out_it != globalNode->outEdgesEnd();
-              ++out_it) {
-             if (!m_partition.contains(Utils::getNodeParent((*out_it)->getDestination().get()))) {
-                 continue;
-             }
-             m_referencedGlobals.insert(&*glob_it);
-         }
+        assert(m_pdg->hasGlobalVariableNode(&*glob_it));
+        globals.push_back(std::make_pair(&*glob_it, m_pdg->getGlobalVariableNode(&*glob_it).get()));
+    }
+    std::vector<Partition::GlobalsSet> secureGlobals(PartitionUtils::getThreadsNum(), m_secureGlobals);
+    std::vector<Partition::GlobalsSet> insecureGlobals(PartitionUtils::getThreadsNum(), m_insecureGlobals);
+    const unsigned shardsNum = PartitionUtils::parallelFor(globals.size(), PartitionUtils::GLOBALS_SHARD_SIZE,
+            [&] (unsigned begin, unsigned end, unsigned shard) {
+                for (unsigned i = begin; i < end; ++i) {
+                    partition(globals[i].first, globals[i].second, secureGlobals[shard], insecureGlobals[shard]);
+                }
+            });
+    for (unsigned shard = 0; shard < shardsNum; ++shard) {
+        m_secureGlobals |= secureGlobals[shard];
+        m_insecureGlobals |= insecureGlobals[shard];
     }
 }
 
-void Partitioner::computeInsecurePartition()
+void PartitionGlobals::partition(llvm::GlobalVariable* global,
+                                 pdg::PDGNode* globalNode,
+                                 Partition::GlobalsSet& secureGlobals,
+                                 Partition::GlobalsSet& insecureGlobals) const
 {
-    for (auto& F : m_module) {
-        if (!m_securePartition.contains(&F)) {
-            m_insecurePartition.addToPartition(&F);
-        }
+    bool secureRef = false;
+    bool insecureRef = false;
+    for (auto in_it = globalNode->inEdgesBegin();
+         in_it != globalNode->inEdgesEnd() && !(secureRef && insecureRef);
+         ++in_it) {
+        addReference(Utils::getNodeParent((*in_it)->getSource().get()), secureRef, insecureRef);
     }
-    PartitionGlobals globals_partitioner(m_module, m_pdg, m_insecurePartition, m_logger);
-    globals_partitioner.partition();
-    m_insecurePartition.setGlobals(globals_partitioner.getReferencedGlobals());
+    for (auto out_it = globalNode->outEdgesBegin();
+         out_it != globalNode->outEdgesEnd() && !(secureRef && insecureRef);
+         ++out_it) {
+        addReference(Utils::getNodeParent((*out_it)->getDestination().get()), secureRef, insecureRef);
+    }
+    if (secureRef) {
+        secureGlobals.insert(global);
+    }
+    if (insecureRef) {
+        insecureGlobals.insert(global);
+    }
+}
 
-    m_insecurePartition.setInInterface(PartitionUtils::computeInInterface(m_insecurePartition.getPartition(), *m_pdg));
-    m_insecurePartition.setOutInterface(PartitionUtils::computeOutInterface(m_insecurePartition.getPartition(), *m_pdg));
+void PartitionGlobals::addReference(llvm::Function* F, bool& secureRef, bool& insecureRef) const
+{
+    if (!F) {
+        return;
+    }
+    if (m_securePartition.contains(F)) {
+        secureRef = true;
+    } else if (m_insecurePartition.contains(F)) {
+        insecureRef = true;
+    }
 }
 
-void Partitioner::partition(const Annotations& annotations)
+Partition Partitioner::sliceAnnotations(const Annotations& annotations, SliceSummaries& summaries)
 {
-    for (const auto& annot : annotations) {
-        m_logger.info("Static analysis for annotation " + annot.getFunction()->getName().str());
-        PartitionForFunction f_partitioner(m_module, annot, m_logger);
-        const auto& f_partition = f_partitioner.partition();
-        m_securePartition.addToPartition(f_partition);
+    // Annotations are sliced independently, each worker accumulating into its own partition.
+    // Merging is union of functions and minimum of levels, thus the same for any assignment of annotations to workers.
+    // Constructed one by one, as copies would share copy-on-write data whose detaching is not thread safe
+    std::vector<Partition> workerPartitions;
+    workerPartitions.reserve(PartitionUtils::getThreadsNum());
+    for (unsigned worker = 0; worker < PartitionUtils::getThreadsNum(); ++worker) {
+        workerPartitions.emplace_back(m_moduleFacts);
+    }
+    const unsigned workersNum = PartitionUtils::parallelForEach(annotations.size(),
+            [&] (unsigned annotationIdx, unsigned worker) {
+                partition(annotations[annotationIdx], summaries, workerPartitions[worker]);
+            });
+    Partition slicePartition(m_moduleFacts);
+    for (unsigned worker = 0; worker < workersNum; ++worker) {
+        slicePartition.addToPartition(workerPartitions[worker]);
+    }
+    return slicePartition;
+}
 
-        PartitionForArguments arg_partitioner(m_module, annot, m_pdg, m_logger);
-        const auto& arg_partition = arg_partitioner.partition();
-        m_securePartition.addToPartition(arg_partition);
+void Partitioner::propagateAnnotations(const Annotations& annotations, const PDGSnapshot& pdgSnapshot)
+{
+    SensitivityPropagation propagation(pdgSnapshot, m_pdg, annotations, m_moduleFacts, m_logger);
+    propagation.propagate();
+    for (unsigned idx = 0; idx < annotations.size(); ++idx) {
+        m_securePartition.addToPartition(propagation.getPartition(idx));
+    }
+    for (const auto& [F, level] : m_securePartition.getRelatedFunctions()) {
+        std::string provenance;
+        for (auto idx : propagation.getProvenance(F)) {
+            provenance += " " + annotations[idx].getFunction()->getName().str();
+        }
+        m_logger.debug("Related function " + F->getName().str() + " level " + std::to_string(level)
+                       + " from annotations" + provenance);
+    }
+}
+
+void Partitioner::partition(const Annotation& annotation,
+                            SliceSummaries& summaries,
+                            Partition& partition) const
+{
+    m_logger.info("Static analysis for annotation " + annotation.getFunction()->getName().str());
+    PartitionForFunction f_partitioner(m_module, annotation, m_moduleFacts, m_logger);
+    partition.addToPartition(f_partitioner.partition());
+
+    PartitionForArguments arg_partitioner(m_module, annotation, m_pdg, summaries, m_moduleFacts, m_logger);
+    partition.addToPartition(arg_partitioner.partition());
+
+    PartitionForReturnValue ret_partitioner(m_module, annotation, m_pdg, summaries, m_moduleFacts, m_logger);
+    partition.addToPartition(ret_partitioner.partition());
+}
+
+void Partitioner::reportSlicingReduction(const Partition& partition, const Partition& baselinePartition) const
+{
+    // Size of the TCB if all related functions end up in the enclave
+    const auto& getTCBSize = [this] (const Partition& slicePartition) {
+        long size = 0;
+        for (auto* F : slicePartition.getPartition()) {
+            size += m_moduleFacts.getCodeSize(F);
+        }
+        for (const auto& [F, level] : slicePartition.getRelatedFunctions()) {
+            if (!slicePartition.contains(F)) {
+                size += m_moduleFacts.getCodeSize(F);
+            }
+        }
+        return size;
+    };
+    const auto& getReduction = [] (long value, long baseline) {
+        return baseline == 0 ? std::string("0%") : std::to_string(100 * (baseline - value) / baseline) + "%";
+    };
+    const long related = partition.getRelatedFunctions().size();
+    const long baselineRelated = baselinePartition.getRelatedFunctions().size();
+    const long tcbSize = getTCBSize(partition);
+    const long baselineTCBSize = getTCBSize(baselinePartition);
+    m_logger.info("Context sensitive slicing: " + std::to_string(related) + " related functions, TCB of "
+                  + std::to_string(tcbSize) + " bytes");
+    m_logger.info("Context insensitive slicing: " + std::to_string(baselineRelated) + " related functions, TCB of "
+                  + std::to_string(baselineTCBSize) + " bytes");
+    m_logger.info("Reduction: " + getReduction(related, baselineRelated) + " related functions, "
+                  + getReduction(tcbSize, baselineTCBSize) + " TCB");
+}
 
-        PartitionForReturnValue ret_partitioner(m_module, annot, m_pdg, m_logger);
-        const auto& ret_partition = ret_partitioner.partition();
-        m_securePartition.addToPartition(ret_partition);
+void Partitioner::computeInsecurePartition(Partition::InterfaceGraphType interfaceGraph)
+{
+    Partition::FunctionSet moduleFunctions(&m_moduleFacts.getFunctionIndex());
+    for (auto& F : m_module) {
+        moduleFunctions.insert(&F);
     }
-    PartitionGlobals globals_partitioner(m_module, m_pdg, m_securePartition, m_logger);
+    moduleFunctions -= m_securePartition.getPartition();
+    m_insecurePartition.setPartition(std::move(moduleFunctions));
+    m_insecurePartition.setInterfaceGraph(interfaceGraph);
+    PartitionUtils::verifyInterfaces(m_insecurePartition, *m_pdg, m_logger);
+}
+
+void Partitioner::partitionGlobals()
+{
+    PartitionGlobals globals_partitioner(m_module, m_pdg, m_securePartition, m_insecurePartition, m_moduleFacts, m_logger);
     globals_partitioner.partition();
-    m_securePartition.setGlobals(globals_partitioner.getReferencedGlobals());
+    m_securePartition.setGlobals(globals_partitioner.getSecureGlobals());
+    m_insecurePartition.setGlobals(globals_partitioner.getInsecureGlobals());
+}
 
-    m_securePartition.setInInterface(PartitionUtils::computeInInterface(m_securePartition.getPartition(), *m_pdg));
-    m_securePartition.setOutInterface(PartitionUtils::computeOutInterface(m_securePartition.getPartition(), *m_pdg));
-    computeInsecurePartition();
+void Partitioner::partition(const Annotations& annotations)
+{
+    m_logger.info("Taking PDG snapshot");
+    // Flattened once and shared by all slicing traversals
+    const PDGSnapshot pdgSnapshot(m_module, *m_pdg, m_moduleFacts.getFunctionIndex());
+    if (Slicer == "bit-parallel") {
+        propagateAnnotations(annotations, pdgSnapshot);
+    } else {
+        const bool contextSensitive = (Slicer == "context-sensitive");
+        // Summaries are shared by annotations reaching the same nodes
+        SliceSummaries summaries(m_pdg, pdgSnapshot, contextSensitive);
+        m_securePartition.addToPartition(sliceAnnotations(annotations, summaries));
+        if (contextSensitive && ReportSlicingReduction) {
+            SliceSummaries baselineSummaries(m_pdg, pdgSnapshot, false);
+            reportSlicingReduction(m_securePartition, sliceAnnotations(annotations, baselineSummaries));
+        }
+    }
+    // Both partitions share the call edges, from now on they keep their interfaces up to date on every move
+    auto interfaceGraph = PartitionUtils::computeInterfaceGraph(*m_pdg, m_moduleFacts);
+    m_securePartition.setInterfaceGraph(interfaceGraph);
+    PartitionUtils::verifyInterfaces(m_securePartition, *m_pdg, m_logger);
+    computeInsecurePartition(interfaceGraph);
+    partitionGlobals();
 }
 
 } // namespace vazgen
@@ -0,0 +1,147 @@
+#include "Analysis/PerformanceHints.h"
+
+#include "Analysis/ModuleFacts.h"
+#include "Utils/Annotation.h"
+#include "Utils/Logger.h"
+
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/Function.h"
+
+namespace vazgen {
+
+PerformanceHints::PerformanceHints(const std::vector<Annotation>& annotations,
+                                   const ModuleFacts& moduleFacts,
+                                   Logger& logger)
+    : m_moduleFacts(moduleFacts)
+    , m_logger(logger)
+    , m_enclavePinned(&moduleFacts.getFunctionIndex())
+    , m_untrustedPinned(&moduleFacts.getFunctionIndex())
+    , m_latencyCriticalCallees(&moduleFacts.getFunctionIndex())
+{
+    for (const auto& annotation : annotations) {
+        llvm::Function* F = annotation.getFunction();
+        const std::string& name = annotation.getAnnotation();
+        if (name == Annotation::PIN_ENCLAVE) {
+            m_enclavePinned.insert(F);
+        } else if (name == Annotation::PIN_UNTRUSTED) {
+            m_untrustedPinned.insert(F);
+        } else if (name == Annotation::CALL_RATE) {
+            m_callRates[F] = annotation.getCallRate();
+        } else if (name == Annotation::LATENCY_CRITICAL) {
+            if (annotation.getLatencyCriticalCallers().empty()) {
+                m_latencyCriticalCallees.insert(F);
+            }
+            for (auto* caller : annotation.getLatencyCriticalCallers()) {
+                m_latencyCriticalCalls.insert(std::make_pair(caller, F));
+            }
+        }
+    }
+    // Latency critical calls are collected once, so that enforcing them does not walk uses
+    for (auto* F : m_latencyCriticalCallees) {
+        for (auto* user : F->users()) {
+            llvm::CallSite callSite(user);
+            if (callSite && callSite.getCalledFunction() == F) {
+                m_latencyCriticalCalls.insert(std::make_pair(callSite.getCaller(), F));
+            }
+        }
+    }
+    for (auto* F : m_enclavePinned) {
+        if (m_untrustedPinned.contains(F)) {
+            m_logger.error("Function " + F->getName().str() + " is pinned to both partitions. Keeping it in enclave");
+            m_untrustedPinned.erase(F);
+        }
+    }
+    if (!empty()) {
+        m_logger.info("Performance hints: " + std::to_string(m_enclavePinned.size()) + " functions pinned to enclave, "
+                      + std::to_string(m_untrustedPinned.size()) + " pinned untrusted, "
+                      + std::to_string(m_callRates.size()) + " call rates, "
+                      + std::to_string(m_latencyCriticalCalls.size()) + " latency critical calls");
+    }
+}
+
+bool PerformanceHints::empty() const
+{
+    return m_enclavePinned.empty() && m_untrustedPinned.empty()
+        && m_callRates.empty() && m_latencyCriticalCalls.empty();
+}
+
+double PerformanceHints::getCallRate(llvm::Function* F) const
+{
+    auto pos = m_callRates.find(F);
+    return pos == m_callRates.end() ? 0 : pos->second;
+}
+
+bool PerformanceHints::isLatencyCritical(llvm::Function* caller, llvm::Function* callee) const
+{
+    return m_latencyCriticalCallees.contains(callee)
+        || m_latencyCriticalCalls.find(std::make_pair(caller, callee)) != m_latencyCriticalCalls.end();
+}
+
+void PerformanceHints::pin(Partition& securePartition, Partition& insecurePartition) const
+{
+    for (auto* F : m_enclavePinned) {
+        if (!securePartition.contains(F)) {
+            moveToEnclave(F, securePartition, insecurePartition);
+        }
+    }
+    for (auto* F : m_untrustedPinned) {
+        if (securePartition.contains(F)) {
+            m_logger.warn("Function " + F->getName().str() + " is pinned untrusted, but is sensitive. Keeping it in enclave");
+        }
+    }
+}
+
+void PerformanceHints::enforce(Partition& securePartition,
+                               Partition& insecurePartition,
+                               const Partition::FunctionSet& sensitivePartition) const
+{
+    pin(securePartition, insecurePartition);
+    for (auto* F : m_untrustedPinned) {
+        if (securePartition.contains(F) && !sensitivePartition.contains(F)) {
+            moveOutOfEnclave(F, securePartition, insecurePartition);
+        }
+    }
+    // Moving one side of a call may make another call cross, iterate until no critical call crosses
+    bool changed = true;
+    for (unsigned iteration = 0; changed && iteration <= m_latencyCriticalCalls.size(); ++iteration) {
+        changed = false;
+        for (const auto& [caller, callee] : m_latencyCriticalCalls) {
+            if (securePartition.contains(caller) == securePartition.contains(callee)) {
+                continue;
+            }
+            auto* secureF = securePartition.contains(caller) ? caller : callee;
+            auto* insecureF = securePartition.contains(caller) ? callee : caller;
+            // Enclave is the safe side, functions are moved in unless pinned out
+            if (!insecureF->isDeclaration() && !isPinnedUntrusted(insecureF)
+                    && !m_moduleFacts.callsForbiddenFunction(insecureF)) {
+                moveToEnclave(insecureF, securePartition, insecurePartition);
+                changed = true;
+            } else if (!sensitivePartition.contains(secureF) && !isPinnedToEnclave(secureF)) {
+                moveOutOfEnclave(secureF, securePartition, insecurePartition);
+                changed = true;
+            }
+        }
+    }
+    for (const auto& [caller, callee] : m_latencyCriticalCalls) {
+        if (securePartition.contains(caller) != securePartition.contains(callee)) {
+            m_logger.warn("Latency critical call from " + caller->getName().str() + " to "
+                          + callee->getName().str() + " crosses the enclave boundary");
+        }
+    }
+}
+
+void PerformanceHints::moveToEnclave(llvm::Function* F, Partition& securePartition, Partition& insecurePartition) const
+{
+    securePartition.addToPartition(F);
+    securePartition.removeRelatedFunction(F);
+    insecurePartition.removeFromPartition(F);
+}
+
+void PerformanceHints::moveOutOfEnclave(llvm::Function* F, Partition& securePartition, Partition& insecurePartition) const
+{
+    securePartition.removeFromPartition(F);
+    insecurePartition.addToPartition(F);
+}
+
+} // namespace vazgen
+
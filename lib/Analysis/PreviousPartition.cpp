@@ -0,0 +1,128 @@
+#include "Analysis/PreviousPartition.h"
+
+#include "Analysis/Partition.h"
+#include "Utils/Logger.h"
+
+#include "llvm/IR/Function.h"
+
+#include "nlohmann/json.hpp"
+
+#include <fstream>
+
+namespace vazgen {
+
+namespace {
+
+// Section headers of ProgramPartition::dump output
+const std::string PARTITION_FUNCTIONS_HEADER = "Partition functions";
+const std::string STATIC_ANALYSER_HEADER = "Static analyser output";
+
+}
+
+PreviousPartition::PreviousPartition(double churnPenalty, Logger& logger)
+    : m_churnPenalty(churnPenalty)
+    , m_logger(logger)
+    , m_hasInsecureFunctions(false)
+{
+}
+
+bool PreviousPartition::load(const std::string& fileName)
+{
+    std::ifstream ifs(fileName, std::ifstream::in);
+    if (!ifs.is_open()) {
+        m_logger.error("Could not open previous partition " + fileName);
+        return false;
+    }
+    ifs >> std::ws;
+    const bool loaded = ifs.peek() == '{' ? loadStats(ifs, fileName) : loadPartitionDump(ifs, fileName);
+    if (loaded) {
+        m_logger.info("Loaded previous partition with " + std::to_string(m_secureFunctions.size())
+                      + " secure functions from " + fileName);
+    }
+    return loaded;
+}
+
+bool PreviousPartition::hasFunction(llvm::Function* F) const
+{
+    const std::string name = F->getName().str();
+    if (m_secureFunctions.find(name) != m_secureFunctions.end()) {
+        return true;
+    }
+    return m_hasInsecureFunctions ? m_insecureFunctions.find(name) != m_insecureFunctions.end() : !empty();
+}
+
+bool PreviousPartition::wasSecure(llvm::Function* F) const
+{
+    return m_secureFunctions.find(F->getName().str()) != m_secureFunctions.end();
+}
+
+double PreviousPartition::getMoveToEnclaveCost(llvm::Function* F) const
+{
+    if (!hasFunction(F)) {
+        return 0;
+    }
+    return wasSecure(F) ? -m_churnPenalty : m_churnPenalty;
+}
+
+unsigned PreviousPartition::getMovedFunctionsNum(const Partition& securePartition,
+                                                 const Partition& insecurePartition) const
+{
+    unsigned moved = 0;
+    for (auto* F : securePartition.getPartition()) {
+        if (hasFunction(F) && !wasSecure(F)) {
+            ++moved;
+        }
+    }
+    for (auto* F : insecurePartition.getPartition()) {
+        if (wasSecure(F)) {
+            ++moved;
+        }
+    }
+    return moved;
+}
+
+bool PreviousPartition::loadStats(std::ifstream& ifs, const std::string& fileName)
+{
+    nlohmann::json root;
+    try {
+        ifs >> root;
+        const auto& partitions = root.at("partition");
+        for (const auto& name : partitions.at("secure_partition").at("partition_functions")) {
+            m_secureFunctions.insert(name.get<std::string>());
+        }
+        auto insecurePos = partitions.find("insecure_partition");
+        if (insecurePos != partitions.end() && insecurePos->find("partition_functions") != insecurePos->end()) {
+            for (const auto& name : insecurePos->at("partition_functions")) {
+                m_insecureFunctions.insert(name.get<std::string>());
+            }
+            m_hasInsecureFunctions = true;
+        }
+    } catch (const nlohmann::json::exception& e) {
+        m_logger.error("Malformed partition statistics " + fileName);
+        m_secureFunctions.clear();
+        m_insecureFunctions.clear();
+        return false;
+    }
+    return true;
+}
+
+bool PreviousPartition::loadPartitionDump(std::ifstream& ifs, const std::string& fileName)
+{
+    std::string line;
+    if (!std::getline(ifs, line) || line.compare(0, PARTITION_FUNCTIONS_HEADER.size(), PARTITION_FUNCTIONS_HEADER) != 0) {
+        m_logger.error("Malformed partition file " + fileName);
+        return false;
+    }
+    while (std::getline(ifs, line)) {
+        if (line.compare(0, STATIC_ANALYSER_HEADER.size(), STATIC_ANALYSER_HEADER) == 0) {
+            break;
+        }
+        if (!line.empty()) {
+            m_secureFunctions.insert(line);
+        }
+    }
+    return true;
+}
+
+} // namespace vazgen
+
@@ -2,6 +2,9 @@
 
 #include "Analysis/Partitioner.h"
 #include "Analysis/PartitionStatistics.h"
+#include "Analysis/PerformanceHints.h"
+#include "Analysis/PreviousPartition.h"
+#include "Utils/Annotation.h"
 #include "Utils/Logger.h"
 #include "Utils/AnnotationParser.h"
 #include "Utils/JsonAnnotationParser.h"
@@ -10,8 +13,11 @@
 
 #include "PDG/Passes/PDGBuildPasses.h"
 
+#include "llvm/Analysis/BlockFrequencyInfo.h"
 #include "llvm/Analysis/CallGraph.h"
 #include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
 #include "llvm/Analysis/PostDominators.h"
 #include "llvm/IR/Dominators.h"
 #include "llvm/IR/Function.h"
@@ -61,29 +67,55 @@ auto getOptimizations(const std::string& optName, Logger& logger)
 ProgramPartition::ProgramPartition(llvm::Module& M,
                                    PDGType pdg,
                                    const llvm::CallGraph& callgraph,
-                                   const LoopInfoGetter& loopInfoGetter,
+                                   const FunctionAnalysesGetter& analysesGetter,
                                    Logger& logger)
     : m_module(M)
     , m_pdg(pdg)
     , m_callgraph(callgraph, logger)
-    , m_loopInfoGetter(loopInfoGetter)
     , m_logger(logger)
+    , m_moduleFacts(std::make_unique<ModuleFacts>(M, *pdg, analysesGetter, logger))
+    , m_hints(std::make_unique<PerformanceHints>(Annotations(), *m_moduleFacts, logger))
+    , m_previousPartition(std::make_unique<PreviousPartition>(0, logger))
+    , m_securePartition(*m_moduleFacts)
+    , m_insecurePartition(*m_moduleFacts)
 {
 }
 
+ProgramPartition::~ProgramPartition() = default;
+
+bool ProgramPartition::loadPreviousPartition(const std::string& fileName, double churnPenalty)
+{
+    m_previousPartition = std::make_unique<PreviousPartition>(churnPenalty, m_logger);
+    return m_previousPartition->load(fileName);
+}
+
 void ProgramPartition::partition(const Annotations& annotations)
 {
-    Partitioner partitioner(m_module, m_pdg, m_logger);
-    partitioner.partition(annotations);
+    Annotations sensitiveAnnotations;
+    Annotations hintAnnotations;
+    for (const auto& annotation : annotations) {
+        if (annotation.isPerformanceHint()) {
+            hintAnnotations.push_back(annotation);
+        } else {
+            sensitiveAnnotations.push_back(annotation);
+        }
+    }
+    m_hints = std::make_unique<PerformanceHints>(hintAnnotations, *m_moduleFacts, m_logger);
+
+    Partitioner partitioner(m_module, m_pdg, *m_moduleFacts, m_logger);
+    partitioner.partition(sensitiveAnnotations);
     m_securePartition = partitioner.getSecurePartition();
     m_insecurePartition = partitioner.getInsecurePartition();
-    m_callgraph.assignWeights(m_securePartition, m_insecurePartition, m_pdg.get(), m_loopInfoGetter);
+    // Hints hold also when no optimization runs
+    const Partition::FunctionSet sensitiveFunctions = m_securePartition.getPartition();
+    m_hints->enforce(m_securePartition, m_insecurePartition, sensitiveFunctions);
+    m_callgraph.assignWeights(m_securePartition, m_insecurePartition, *m_moduleFacts, *m_hints);
 }
 
 void ProgramPartition::optimize(auto optimizations)
 {
-    PartitionOptimizer optimizer(m_securePartition, m_insecurePartition, m_pdg, m_callgraph, m_logger);
-    optimizer.setLoopInfoGetter(m_loopInfoGetter);
+    PartitionOptimizer optimizer(m_securePartition, m_insecurePartition, m_pdg, m_callgraph, *m_moduleFacts,
+                                 *m_hints, *m_previousPartition, m_logger);
     optimizer.run(optimizations);
 }
 
@@ -118,7 +150,7 @@ void ProgramPartition::dumpStats(const std::string& statsFile) const
     } else {
         strm.open(statsFile);
     }
-    PartitionStatistics stats(strm, m_securePartition, m_insecurePartition, m_callgraph, m_module);
+    PartitionStatistics stats(strm, m_securePartition, m_insecurePartition, m_callgraph, *m_moduleFacts, m_module);
     stats.report();
 }
 
@@ -137,6 +169,17 @@ llvm::cl::opt<bool> Stats(
     llvm::cl::desc("Dump partition stats"),
     llvm::cl::value_desc("flag to dump stats"));
 
+llvm::cl::opt<std::string> PreviousPartitionFile(
+    "previous-partition",
+    llvm::cl::desc("Partition stats or outfile of an earlier run to re-optimize from"),
+    llvm::cl::value_desc("previous partition file"));
+
+llvm::cl::opt<double> ChurnPenalty(
+    "churn-penalty",
+    llvm::cl::desc("Cost of placing a function differently than in the previous partition, relative to normalized node and edge weights"),
+    llvm::cl::value_desc("penalty"),
+    llvm::cl::init(1.0));
+
 // This is running the simplest optimization passes
 llvm::cl::opt<std::string> Opt(
     "optimize",
@@ -149,6 +192,9 @@ void ProgramPartitionAnalysis::getAnalysisUsage(llvm::AnalysisUsage& AU) const
 {
     AU.addRequired<pdg::SVFGPDGBuilder>();
     AU.addRequired<llvm::LoopInfoWrapperPass>();
+    AU.addRequired<llvm::BlockFrequencyInfoWrapperPass>();
+    AU.addRequired<llvm::ScalarEvolutionWrapperPass>();
+    AU.addRequired<llvm::TargetTransformInfoWrapperPass>();
     AU.addRequired<llvm::CallGraphWrapperPass>();
     AU.setPreservesAll();
 }
@@ -169,9 +215,23 @@ bool ProgramPartitionAnalysis::runOnModule(llvm::Module& M)
 
     auto pdg = getAnalysis<pdg::SVFGPDGBuilder>().getPDG();
     llvm::CallGraph& CG = getAnalysis<llvm::CallGraphWrapperPass>().getCallGraph();
-    const auto& loopGetter = [this] (llvm::Function* F)
-        {   return &this->getAnalysis<llvm::LoopInfoWrapperPass>(*F).getLoopInfo(); };
-    m_partition.reset(new ProgramPartition(M, pdg, CG, loopGetter, logger));
+    // Every request runs all function analyses for F, so pointers are taken after the last one
+    const auto& analysesGetter = [this] (llvm::Function* F)
+        {
+            auto& loopPass = this->getAnalysis<llvm::LoopInfoWrapperPass>(*F);
+            auto& blockFrequencyPass = this->getAnalysis<llvm::BlockFrequencyInfoWrapperPass>(*F);
+            auto& scalarEvolutionPass = this->getAnalysis<llvm::ScalarEvolutionWrapperPass>(*F);
+            ModuleFacts::FunctionAnalyses analyses;
+            analyses.loopInfo = &loopPass.getLoopInfo();
+            analyses.blockFrequency = &blockFrequencyPass.getBFI();
+            analyses.scalarEvolution = &scalarEvolutionPass.getSE();
+            analyses.targetTransformInfo = &this->getAnalysis<llvm::TargetTransformInfoWrapperPass>().getTTI(*F);
+            return analyses;
+        };
+    m_partition.reset(new ProgramPartition(M, pdg, CG, analysesGetter, logger));
+    if (!PreviousPartitionFile.empty()) {
+        m_partition->loadPreviousPartition(PreviousPartitionFile, ChurnPenalty);
+    }
     m_partition->partition(annotations);
     if (!Opt.empty()) {
         const auto& optimizations = getOptimizations(Opt, logger);
@@ -41,25 +41,24 @@ void ProgramPartitionStatisticsPass::getAnalysisUsage(llvm::AnalysisUsage& AU) c
 
 bool ProgramPartitionStatisticsPass::runOnModule(llvm::Module& M)
 {
-    const auto& insecurePartition = getAnalysis<ProgramPartitionAnalysis>().getProgramPartition().getInsecurePartition();
-    const auto& securePartition = getAnalysis<ProgramPartitionAnalysis>().getProgramPartition().getSecurePartition();
+    const auto& programPartition = getAnalysis<ProgramPartitionAnalysis>().getProgramPartition();
+    const auto& insecurePartition = programPartition.getInsecurePartition();
+    const auto& securePartition = programPartition.getSecurePartition();
+    const auto& moduleFacts = programPartition.getModuleFacts();
     llvm::CallGraph& CG = getAnalysis<llvm::CallGraphWrapperPass>().getCallGraph();
-    auto pdg = getAnalysis<pdg::SVFGPDGBuilder>().getPDG();
-    const auto& loopGetter = [this] (llvm::Function* F)
-        {   return &this->getAnalysis<llvm::LoopInfoWrapperPass>(*F).getLoopInfo(); };
 
     Logger logger("Program partition statistics");
     logger.setLevel(vazgen::Logger::INFO);
 
     CallGraph callGraph(CG, logger);
-    callGraph.assignWeights(securePartition, insecurePartition, pdg.get(), loopGetter);
+    callGraph.assignWeights(securePartition, insecurePartition, moduleFacts, programPartition.getPerformanceHints());
     std::ofstream strm;
     if (StatsFile.empty()) {
         strm.open("partition_stats.json");
     } else {
         strm.open(StatsFile);
     }
-    PartitionStatistics stats(strm, securePartition, insecurePartition, callGraph, M);
+    PartitionStatistics stats(strm, securePartition, insecurePartition, callGraph, moduleFacts, M);
     stats.report();
 
     return false;
@@ -0,0 +1,393 @@
+#include "Analysis/SensitivityPropagation.h"
+
+#include "Analysis/ModuleFacts.h"
+#include "Analysis/PDGSnapshot.h"
+#include "Utils/Logger.h"
+
+#include "PDG/PDG/PDG.h"
+#include "PDG/PDG/PDGNode.h"
+#include "PDG/PDG/FunctionPDG.h"
+
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+
+#include <algorithm>
+#include <queue>
+
+namespace vazgen {
+
+namespace {
+
+const unsigned WORD_BITS = 64;
+
+bool isEmpty(const std::vector<std::uint64_t>& mask)
+{
+    return std::all_of(mask.begin(), mask.end(), [] (std::uint64_t word) { return word == 0; });
+}
+
+template <typename SourceFunction>
+void forEachSource(const std::vector<std::uint64_t>& mask, const SourceFunction& sourceF)
+{
+    for (unsigned w = 0; w < mask.size(); ++w) {
+        std::uint64_t word = mask[w];
+        while (word != 0) {
+            sourceF(w * WORD_BITS + __builtin_ctzll(word));
+            word &= word - 1;
+        }
+    }
+}
+
+std::uint64_t getEdgeKey(unsigned from, unsigned to)
+{
+    return (static_cast<std::uint64_t>(from) << 32) | to;
+}
+
+}
+
+SensitivityPropagation::SensitivityPropagation(const PDGSnapshot& pdgSnapshot,
+                                               PDGType pdg,
+                                               const Annotations& annotations,
+                                               const ModuleFacts& moduleFacts,
+                                               Logger& logger)
+    : m_pdgSnapshot(pdgSnapshot)
+    , m_pdg(pdg)
+    , m_annotations(annotations)
+    , m_moduleFacts(moduleFacts)
+    , m_functionIndex(moduleFacts.getFunctionIndex())
+    , m_logger(logger)
+    , m_wordsNum(1)
+{
+}
+
+void SensitivityPropagation::propagate()
+{
+    addSources();
+    m_logger.info("Propagating " + std::to_string(m_sources.size()) + " annotation sources through PDG");
+    propagateForward();
+    propagateBackward();
+    computePartitions();
+}
+
+std::vector<unsigned> SensitivityPropagation::getProvenance(llvm::Function* F) const
+{
+    std::vector<unsigned> annotations;
+    const unsigned id = m_functionIndex.getId(F);
+    auto pos = m_relatedFunctions.find(id);
+    if (id == ValueIndex<llvm::Function>::INVALID_ID || pos == m_relatedFunctions.end()) {
+        return annotations;
+    }
+    forEachSource(pos->second, [&] (unsigned source) {
+                annotations.push_back(m_sources[source].annotationIdx);
+            });
+    // argument and return value sources of the same annotation are next to each other
+    annotations.erase(std::unique(annotations.begin(), annotations.end()), annotations.end());
+    return annotations;
+}
+
+void SensitivityPropagation::addSources()
+{
+    // Same conditions as PartitionForArguments::canPartition and PartitionForReturnValue::canPartition
+    for (unsigned idx = 0; idx < m_annotations.size(); ++idx) {
+        llvm::Function* F = m_annotations[idx].getFunction();
+        if (!F || !m_pdg->hasFunctionPDG(F)) {
+            continue;
+        }
+        const auto& annotatedArgs = m_annotations[idx].getAnnotatedArguments();
+        const bool pointerArgs = std::all_of(annotatedArgs.begin(), annotatedArgs.end(),
+                [F] (unsigned arg_idx) { return (F->arg_begin() + arg_idx)->getType()->isPointerTy(); });
+        if (!annotatedArgs.empty() && pointerArgs) {
+            m_sources.push_back(Source{idx, F, false});
+        }
+        if (m_annotations[idx].isReturnAnnotated() && !F->getReturnType()->isVoidTy()) {
+            m_sources.push_back(Source{idx, F, true});
+        }
+    }
+    m_wordsNum = std::max(1u, static_cast<unsigned>((m_sources.size() + WORD_BITS - 1) / WORD_BITS));
+    m_returnSources.assign(m_wordsNum, 0);
+    for (auto* propagation : {&m_forward, &m_backward}) {
+        propagation->visited.assign(m_pdgSnapshot.size() * m_wordsNum, 0);
+        propagation->pending.assign(m_pdgSnapshot.size() * m_wordsNum, 0);
+        propagation->inWorkingList.assign(m_pdgSnapshot.size(), false);
+    }
+    for (unsigned source = 0; source < m_sources.size(); ++source) {
+        if (m_sources[source].isReturn) {
+            m_returnSources[source / WORD_BITS] |= std::uint64_t(1) << (source % WORD_BITS);
+            addReturnSeeds(source);
+        } else {
+            addArgumentSeeds(source);
+        }
+    }
+}
+
+void SensitivityPropagation::addArgumentSeeds(unsigned source)
+{
+    llvm::Function* F = m_sources[source].function;
+    auto Fpdg = m_pdg->getFunctionPDG(F);
+    for (auto arg_idx : m_annotations[m_sources[source].annotationIdx].getAnnotatedArguments()) {
+        auto* arg = &*(F->arg_begin() + arg_idx);
+        if (!Fpdg->hasFormalArgNode(arg)) {
+            continue;
+        }
+        const unsigned formalArgNode = m_pdgSnapshot.getNodeId(Fpdg->getFormalArgNode(arg).get());
+        if (formalArgNode != PDGSnapshot::INVALID_NODE) {
+            pushSource(m_forward, formalArgNode, source);
+        }
+    }
+}
+
+void SensitivityPropagation::addReturnSeeds(unsigned source)
+{
+    llvm::Function* F = m_sources[source].function;
+    auto Fpdg = m_pdg->getFunctionPDG(F);
+    for (auto& B : *F) {
+        auto* retInst = llvm::dyn_cast_or_null<llvm::ReturnInst>(B.getTerminator());
+        if (!retInst || !Fpdg->hasNode(retInst)) {
+            continue;
+        }
+        const unsigned retNode = m_pdgSnapshot.getNodeId(Fpdg->getNode(retInst).get());
+        if (retNode != PDGSnapshot::INVALID_NODE) {
+            pushSource(m_backward, retNode, source);
+        }
+    }
+}
+
+void SensitivityPropagation::propagateForward()
+{
+    unsigned node;
+    Mask sources(m_wordsNum);
+    while (takeNode(m_forward, node, sources)) {
+        if (!m_pdgSnapshot.isLLVMNode(node) || !m_pdgSnapshot.getValue(node)) {
+            continue;
+        }
+        Word* visited = m_forward.visited.data() + node * m_wordsNum;
+        for (unsigned w = 0; w < m_wordsNum; ++w) {
+            visited[w] |= sources[w];
+        }
+        const auto kind = m_pdgSnapshot.getKind(node);
+        if (kind == PDGSnapshot::FUNCTION) {
+            auto* F = m_pdgSnapshot.getNodeFunction(node);
+            if (!F->isDeclaration()) {
+                addRelatedFunction(F, excludeAnnotatedBy(F, sources));
+            }
+            // Stop traversal here
+            continue;
+        }
+        auto* currentParent = m_pdgSnapshot.getParent(node);
+        if (kind == PDGSnapshot::ACTUAL_ARG && m_pdgSnapshot.isPointerActualArg(node)) {
+            for (auto destNode : m_pdgSnapshot.getOutEdges(node)) {
+                if (m_pdgSnapshot.getKind(destNode) != PDGSnapshot::FORMAL_ARG) {
+                    continue;
+                }
+                llvm::Function* F = m_pdgSnapshot.getNodeFunction(destNode);
+                if (!m_pdg->hasFunctionPDG(F)) {
+                    continue;
+                }
+                if (!F->isDeclaration()) {
+                    addLevelEdge(currentParent, F, sources);
+                    addRelatedFunction(F, sources);
+                }
+                push(m_forward, destNode, sources);
+            }
+        }
+        if (llvm::isa<llvm::StoreInst>(m_pdgSnapshot.getValue(node))) {
+            collectStoreSeeds(node, sources);
+        }
+        for (auto destNode : m_pdgSnapshot.getOutEdges(node)) {
+            if (!m_pdgSnapshot.canProcessNode(destNode)) {
+                continue;
+            }
+            push(m_forward, destNode, sources);
+            addLevelEdge(currentParent, m_pdgSnapshot.getParent(destNode), sources);
+        }
+    }
+}
+
+void SensitivityPropagation::propagateBackward()
+{
+    unsigned node;
+    Mask sources(m_wordsNum);
+    while (takeNode(m_backward, node, sources)) {
+        if (!m_pdgSnapshot.isLLVMNode(node)) {
+            continue;
+        }
+        if (!m_pdgSnapshot.getValue(node)) {
+            // Only return value traversal goes through nodes without values
+            for (unsigned w = 0; w < m_wordsNum; ++w) {
+                sources[w] &= m_returnSources[w];
+            }
+            if (isEmpty(sources)) {
+                continue;
+            }
+        }
+        Word* visited = m_backward.visited.data() + node * m_wordsNum;
+        for (unsigned w = 0; w < m_wordsNum; ++w) {
+            visited[w] |= sources[w];
+        }
+        if (m_pdgSnapshot.getKind(node) == PDGSnapshot::FUNCTION) {
+            auto* F = m_pdgSnapshot.getNodeFunction(node);
+            if (!F->isDeclaration()) {
+                addRelatedFunction(F, excludeAnnotatedBy(F, sources));
+            }
+            // Stop traversal here
+            continue;
+        }
+        auto* currentParent = m_pdgSnapshot.getParent(node);
+        for (auto sourceNode : m_pdgSnapshot.getInEdges(node)) {
+            if (!m_pdgSnapshot.canProcessNode(sourceNode)) {
+                continue;
+            }
+            push(m_backward, sourceNode, sources);
+            addLevelEdge(currentParent, m_pdgSnapshot.getParent(sourceNode), sources);
+        }
+    }
+}
+
+void SensitivityPropagation::collectStoreSeeds(unsigned node, const Mask& sources)
+{
+    // Value operand is looked up in PDG of annotated function, as PartitionForArguments::traverseForward does
+    auto* valueOp = llvm::cast<llvm::StoreInst>(m_pdgSnapshot.getValue(node))->getValueOperand();
+    forEachSource(sources, [&] (unsigned source) {
+            auto Fpdg = m_pdg->getFunctionPDG(m_sources[source].function);
+            if (!Fpdg->hasNode(valueOp)) {
+                return;
+            }
+            const unsigned valueNode = m_pdgSnapshot.getNodeId(Fpdg->getNode(valueOp).get());
+            if (valueNode != PDGSnapshot::INVALID_NODE) {
+                pushSource(m_backward, valueNode, source);
+            }
+        });
+}
+
+void SensitivityPropagation::computePartitions()
+{
+    m_partitions.assign(m_annotations.size(), Partition(m_moduleFacts));
+    for (unsigned idx = 0; idx < m_annotations.size(); ++idx) {
+        if (auto* F = m_annotations[idx].getFunction()) {
+            m_partitions[idx].addToPartition(F);
+        }
+    }
+    std::vector<std::vector<std::pair<unsigned, unsigned>>> sourceEdges(m_sources.size());
+    for (const auto& [key, sources] : m_levelEdges) {
+        forEachSource(sources, [&] (unsigned source) {
+                sourceEdges[source].push_back(std::make_pair(key >> 32, key & 0xffffffff));
+            });
+    }
+    for (unsigned source = 0; source < m_sources.size(); ++source) {
+        // Levels grow by one on each call edge, so breadth first order gives minimal ones
+        std::unordered_map<unsigned, std::vector<unsigned>> callees;
+        for (const auto& [from, to] : sourceEdges[source]) {
+            callees[from].push_back(to);
+        }
+        std::unordered_map<unsigned, int> levels;
+        std::queue<unsigned> workingList;
+        const unsigned root = m_functionIndex.getId(m_sources[source].function);
+        levels.insert(std::make_pair(root, 0));
+        workingList.push(root);
+        while (!workingList.empty()) {
+            const unsigned current = workingList.front();
+            workingList.pop();
+            const int level = levels[current];
+            for (auto callee : callees[current]) {
+                if (levels.insert(std::make_pair(callee, level + 1)).second) {
+                    workingList.push(callee);
+                }
+            }
+        }
+
+        Partition sourcePartition(m_moduleFacts);
+        for (const auto& [function, sources] : m_relatedFunctions) {
+            if ((sources[source / WORD_BITS] & (std::uint64_t(1) << (source % WORD_BITS))) == 0) {
+                continue;
+            }
+            auto* F = m_functionIndex.getValue(function);
+            auto level = levels.find(function);
+            if (level == levels.end()) {
+                m_logger.error("No level for function " + F->getName().str());
+                continue;
+            }
+            sourcePartition.addRelatedFunction(F, level->second);
+        }
+        m_partitions[m_sources[source].annotationIdx].addToPartition(sourcePartition);
+    }
+}
+
+bool SensitivityPropagation::takeNode(Propagation& propagation, unsigned& node, Mask& sources)
+{
+    while (!propagation.workingList.empty()) {
+        node = propagation.workingList.pop();
+        propagation.inWorkingList[node] = false;
+        Word* pending = propagation.pending.data() + node * m_wordsNum;
+        const Word* visited = propagation.visited.data() + node * m_wordsNum;
+        bool hasSources = false;
+        for (unsigned w = 0; w < m_wordsNum; ++w) {
+            sources[w] = pending[w] & ~visited[w];
+            pending[w] = 0;
+            hasSources |= (sources[w] != 0);
+        }
+        if (hasSources) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void SensitivityPropagation::push(Propagation& propagation, unsigned node, const Mask& sources)
+{
+    Word* pending = propagation.pending.data() + node * m_wordsNum;
+    const Word* visited = propagation.visited.data() + node * m_wordsNum;
+    bool hasNewSources = false;
+    for (unsigned w = 0; w < m_wordsNum; ++w) {
+        const Word newSources = sources[w] & ~visited[w] & ~pending[w];
+        pending[w] |= newSources;
+        hasNewSources |= (newSources != 0);
+    }
+    if (hasNewSources && !propagation.inWorkingList[node]) {
+        propagation.inWorkingList[node] = true;
+        propagation.workingList.push(node);
+    }
+}
+
+void SensitivityPropagation::pushSource(Propagation& propagation, unsigned node, unsigned source)
+{
+    Mask sources(m_wordsNum, 0);
+    sources[source / WORD_BITS] |= std::uint64_t(1) << (source % WORD_BITS);
+    push(propagation, node, sources);
+}
+
+void SensitivityPropagation::addLevelEdge(llvm::Function* from, llvm::Function* to, const Mask& sources)
+{
+    if (!from || !to || from == to) {
+        return;
+    }
+    auto& edgeSources = m_levelEdges[getEdgeKey(m_functionIndex.getId(from), m_functionIndex.getId(to))];
+    edgeSources.resize(m_wordsNum, 0);
+    for (unsigned w = 0; w < m_wordsNum; ++w) {
+        edgeSources[w] |= sources[w];
+    }
+}
+
+void SensitivityPropagation::addRelatedFunction(llvm::Function* F, const Mask& sources)
+{
+    if (isEmpty(sources)) {
+        return;
+    }
+    auto& relatedSources = m_relatedFunctions[m_functionIndex.getId(F)];
+    relatedSources.resize(m_wordsNum, 0);
+    for (unsigned w = 0; w < m_wordsNum; ++w) {
+        relatedSources[w] |= sources[w];
+    }
+}
+
+SensitivityPropagation::Mask SensitivityPropagation::excludeAnnotatedBy(llvm::Function* F, const Mask& sources) const
+{
+    Mask result = sources;
+    forEachSource(sources, [&] (unsigned source) {
+            if (m_sources[source].function == F) {
+                result[source / WORD_BITS] &= ~(std::uint64_t(1) << (source % WORD_BITS));
+            }
+        });
+    return result;
+}
+
+} // namespace vazgen
+
@@ -0,0 +1,159 @@
+#include "Analysis/SliceSummaries.h"
+
+#include "Analysis/ContextSensitiveSlicer.h"
+#include "Analysis/PDGSnapshot.h"
+#include "Utils/RingBuffer.h"
+
+#include "PDG/PDG/PDG.h"
+#include "PDG/PDG/PDGNode.h"
+#include "PDG/PDG/FunctionPDG.h"
+
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+
+#include <mutex>
+
+namespace vazgen {
+
+SliceSummaries::SliceSummaries(PDGType pdg,
+                               const PDGSnapshot& pdgSnapshot,
+                               bool contextSensitive)
+    : m_pdg(pdg)
+    , m_pdgSnapshot(pdgSnapshot)
+{
+    if (contextSensitive) {
+        m_contextSensitiveSlicer.reset(new ContextSensitiveSlicer(m_pdg, m_pdgSnapshot));
+    }
+}
+
+SliceSummaries::~SliceSummaries() = default;
+
+SliceSummaries::SummaryType SliceSummaries::getSummary(unsigned node, Direction direction)
+{
+    const auto key = getKey(node, direction);
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        auto pos = m_summaries.find(key);
+        if (pos != m_summaries.end()) {
+            return pos->second;
+        }
+    }
+    // Computed without holding the lock. Concurrent computations of the same summary give the same result
+    auto summary = computeSummary(node, direction);
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    return m_summaries.insert(std::make_pair(key, summary)).first->second;
+}
+
+SliceSummaries::SummaryType SliceSummaries::computeSummary(unsigned node, Direction direction) const
+{
+    if (m_contextSensitiveSlicer) {
+        return m_contextSensitiveSlicer->slice(node, direction);
+    }
+    switch (direction) {
+    case FORWARD:
+        return computeForwardSummary(node);
+    case BACKWARD:
+        return computeBackwardSummary(node, false);
+    case RETURN_BACKWARD:
+        return computeBackwardSummary(node, true);
+    }
+    return SummaryType();
+}
+
+SliceSummaries::SummaryType SliceSummaries::computeForwardSummary(unsigned node) const
+{
+    SliceSummaryBuilder builder;
+    RingBuffer<unsigned> workingList;
+    std::vector<bool> processedNodes(m_pdgSnapshot.size());
+    workingList.push(node);
+
+    while (!workingList.empty()) {
+        const unsigned currentNode = workingList.pop();
+        if (!m_pdgSnapshot.isLLVMNode(currentNode)) {
+            continue;
+        }
+        auto* nodeValue = m_pdgSnapshot.getValue(currentNode);
+        if (!nodeValue || processedNodes[currentNode]) {
+            continue;
+        }
+        processedNodes[currentNode] = true;
+        const auto kind = m_pdgSnapshot.getKind(currentNode);
+        if (kind == PDGSnapshot::FUNCTION) {
+            auto* F = m_pdgSnapshot.getNodeFunction(currentNode);
+            if (!F->isDeclaration()) {
+                builder.addReachedFunction(F);
+            }
+            // Stop traversal here
+            // TODO: should we stop here or continue for other function calls?
+            // i.e. find the formal argument for this call site and continue traversal for it.
+            continue;
+        }
+        auto* currentParent = m_pdgSnapshot.getParent(currentNode);
+        if (kind == PDGSnapshot::ACTUAL_ARG && m_pdgSnapshot.isPointerActualArg(currentNode)) {
+            for (auto destNode : m_pdgSnapshot.getOutEdges(currentNode)) {
+                if (m_pdgSnapshot.getKind(destNode) != PDGSnapshot::FORMAL_ARG) {
+                    continue;
+                }
+                llvm::Function* F = m_pdgSnapshot.getNodeFunction(destNode);
+                if (!m_pdg->hasFunctionPDG(F)) {
+                    continue;
+                }
+                if (!F->isDeclaration()) {
+                    builder.addFunctionEdge(currentParent, F);
+                    builder.addCalledFunction(F);
+                }
+                workingList.push(destNode);
+            }
+        }
+        if (auto* storeInst = llvm::dyn_cast<llvm::StoreInst>(nodeValue)) {
+            builder.addStoredValue(storeInst->getValueOperand());
+        }
+        for (auto destNode : m_pdgSnapshot.getOutEdges(currentNode)) {
+            if (!m_pdgSnapshot.canProcessNode(destNode)) {
+                continue;
+            }
+            workingList.push(destNode);
+            builder.addFunctionEdge(currentParent, m_pdgSnapshot.getParent(destNode));
+        }
+    }
+    return builder.getSummary();
+}
+
+SliceSummaries::SummaryType SliceSummaries::computeBackwardSummary(unsigned node, bool throughNonValueNodes) const
+{
+    SliceSummaryBuilder builder;
+    RingBuffer<unsigned> workingList;
+    std::vector<bool> processedNodes(m_pdgSnapshot.size());
+    workingList.push(node);
+
+    while (!workingList.empty()) {
+        const unsigned currentNode = workingList.pop();
+        if (!m_pdgSnapshot.isLLVMNode(currentNode) || processedNodes[currentNode]) {
+            continue;
+        }
+        if (!m_pdgSnapshot.getValue(currentNode) && !throughNonValueNodes) {
+            continue;
+        }
+        processedNodes[currentNode] = true;
+        if (m_pdgSnapshot.getKind(currentNode) == PDGSnapshot::FUNCTION) {
+            auto* F = m_pdgSnapshot.getNodeFunction(currentNode);
+            if (!F->isDeclaration()) {
+                builder.addReachedFunction(F);
+            }
+            // Stop traversal here
+            continue;
+        }
+        auto* currentParent = m_pdgSnapshot.getParent(currentNode);
+        for (auto sourceNode : m_pdgSnapshot.getInEdges(currentNode)) {
+            if (!m_pdgSnapshot.canProcessNode(sourceNode)) {
+                continue;
+            }
+            workingList.push(sourceNode);
+            builder.addFunctionEdge(currentParent, m_pdgSnapshot.getParent(sourceNode));
+        }
+    }
+    return builder.getSummary();
+}
+
+} // namespace vazgen
+
@@ -0,0 +1,46 @@
+#include "Analysis/TransitionCostProfile.h"
+
+#include "Utils/Logger.h"
+
+#include "nlohmann/json.hpp"
+
+#include <fstream>
+
+namespace vazgen {
+
+TransitionCostProfile::TransitionCostProfile(Logger& logger)
+    : m_logger(logger)
+    , m_transitionNs(0)
+    , m_byteCopyNs(0)
+{
+}
+
+bool TransitionCostProfile::load(const std::string& fileName)
+{
+    std::ifstream ifs(fileName, std::ifstream::in);
+    if (!ifs.is_open()) {
+        m_logger.error("Can not open transition cost profile " + fileName);
+        return false;
+    }
+    nlohmann::json root;
+    try {
+        ifs >> root;
+        m_backend = root.value("backend", std::string("unknown"));
+        m_transitionNs = root.at("transition_ns").get<double>();
+        m_byteCopyNs = root.at("byte_copy_ns").get<double>();
+    } catch (const nlohmann::json::exception& e) {
+        m_logger.error("Malformed transition cost profile " + fileName);
+        return false;
+    }
+    if (m_transitionNs < 0 || m_byteCopyNs < 0) {
+        m_logger.error("Negative costs in transition cost profile " + fileName);
+        return false;
+    }
+    m_logger.info("Transition cost profile of " + m_backend + " backend: "
+                  + std::to_string(m_transitionNs) + "ns per transition, "
+                  + std::to_string(m_byteCopyNs) + "ns per byte");
+    return true;
+}
+
+} // namespace vazgen
+
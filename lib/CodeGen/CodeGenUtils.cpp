@@ -34,6 +34,7 @@ CodeGenUtils::parseFunctionsFromStats(const std::string& statsFile, Logger& logg
     result.first.insert(secureFunctions.begin(), secureFunctions.end());
     const auto& insecureFunctions = stats["partition"]["insecure_partition"]["in_interface"];
     result.second.insert(insecureFunctions.begin(), insecureFunctions.end());
+    return result;
 }
 
 } // namespace vazgen
@@ -92,8 +92,11 @@ std::string getMessageNameForType(llvm::Type* type)
 } // unnamed namespace
 
 
-ProtoFileGenerator::ProtoFileGenerator(const Partition& partition, const std::string& protoName)
+ProtoFileGenerator::ProtoFileGenerator(const Partition& partition,
+                                       const FunctionSet& additionalFunctions,
+                                       const std::string& protoName)
     : m_partition(partition)
+    , m_additionalFunctions(additionalFunctions)
     , m_protoName(protoName)
 {
 }
@@ -111,6 +114,9 @@ void ProtoFileGenerator::generateMessages()
     for (auto* F : m_partition.getPartition()) {
         generateMessagesForFunction(F);
     }
+    for (auto* F : m_additionalFunctions) {
+        generateMessagesForFunction(F);
+    }
 }
 
 void ProtoFileGenerator::generateMessagesForFunction(llvm::Function* F)
@@ -10,6 +10,7 @@ namespace vazgen {
 
 DuplicateFunctionsOptimization::DuplicateFunctionsOptimization(Partition& partition, Logger& logger)
     : PartitionOptimization(partition, nullptr, logger, PartitionOptimizer::DUPLICATE_FUNCTIONS)
+    , m_duplicatedFunctions(partition.getPartition().getIndex())
 {
 }
 
@@ -1,4 +1,5 @@
 #include "Optimization/FunctionsMoveToPartitionOptimization.h"
+#include "Analysis/PerformanceHints.h"
 #include "Utils/Logger.h"
 
 #include "PDG/PDG/PDG.h"
@@ -6,9 +7,6 @@
 #include "PDG/PDG/PDGEdge.h"
 #include "PDG/PDG/FunctionPDG.h"
 
-#include "llvm/Analysis/LoopInfo.h"
-#include "llvm/IR/BasicBlock.h"
-#include "llvm/IR/CallSite.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/Module.h"
@@ -20,10 +18,13 @@ namespace vazgen {
 FunctionsMoveToPartitionOptimization::
 FunctionsMoveToPartitionOptimization(Partition& partition,
                                      PDGType pdg,
-                                     Logger& logger,
-                                     const LoopInfoGetter& loopInfoGetter)
+                                     const ModuleFacts& moduleFacts,
+                                     const PerformanceHints& hints,
+                                     Logger& logger)
     : PartitionOptimization(partition, pdg, logger, PartitionOptimizer::FUNCTIONS_MOVE_TO)
-    , m_loopInfoGetter(loopInfoGetter)
+    , m_moduleFacts(moduleFacts)
+    , m_hints(hints)
+    , m_movedFunctions(&moduleFacts.getFunctionIndex())
 {
 }
 
@@ -47,17 +48,16 @@ FunctionsMoveToPartitionOptimization::computeFunctionsCalledFromPartitionOnly()
 {
     // Move function to partition if it's called from partition only
     // Operate on out-interface as out-interface contains all calls from enclave to outside world
-    Partition::FunctionSet functionsToMove;
+    Partition::FunctionSet functionsToMove(&m_moduleFacts.getFunctionIndex());
     for (auto* F : m_partition.getOutInterface()) {
         if (m_movedFunctions.find(F) != m_movedFunctions.end()) {
             continue;
         }
-        if (F->isDeclaration()) {
+        if (F->isDeclaration() || m_hints.isPinned(F) || m_moduleFacts.callsForbiddenFunction(F)) {
             continue;
         }
         assert(m_pdg->hasFunctionPDG(F));
-        const auto Fpdg = m_pdg->getFunctionPDG(F);
-        const auto& callSites = Fpdg->getCallSites();
+        const auto& callSites = m_moduleFacts.getCallSites(F);
         if (!hasCallSiteOutsidePartition(callSites)) {
             functionsToMove.insert(F);
         }
@@ -69,16 +69,15 @@ Partition::FunctionSet
 FunctionsMoveToPartitionOptimization::computeFunctionsCalledFromPartitionLoops()
 {
     // Move function from out-interface to partition if it's called in loop
-    Partition::FunctionSet functionsToMove;
+    Partition::FunctionSet functionsToMove(&m_moduleFacts.getFunctionIndex());
     for (auto* F : m_partition.getOutInterface()) {
         if (m_movedFunctions.find(F) != m_movedFunctions.end()) {
             continue;
         }
-        if (F->isDeclaration()) {
+        if (F->isDeclaration() || m_hints.isPinned(F) || m_moduleFacts.callsForbiddenFunction(F)) {
             continue;
         }
-        const auto Fpdg = m_pdg->getFunctionPDG(F);
-        const auto& callSites = Fpdg->getCallSites();
+        const auto& callSites = m_moduleFacts.getCallSites(F);
         if (hasCallSiteInLoop(callSites)) {
             functionsToMove.insert(F);
         }
@@ -90,7 +89,7 @@ bool FunctionsMoveToPartitionOptimization::
 hasCallSiteOutsidePartition(const CallSites& callSites) const
 {
     for (const auto& callSite : callSites) {
-        if (!m_partition.contains(callSite.getCaller())) {
+        if (!m_partition.contains(callSite.caller)) {
             return true;
         }
     }
@@ -101,17 +100,10 @@ bool FunctionsMoveToPartitionOptimization::
 hasCallSiteInLoop(const CallSites& callSites) const
 {
     for (const auto& callSite : callSites) {
-        llvm::Function* caller = callSite.getCaller();
-        if (!m_partition.contains(caller)) {
+        if (!m_partition.contains(callSite.caller)) {
             continue;
         }
-        auto* loopInfo = m_loopInfoGetter(caller);
-        if (!loopInfo) {
-            continue;
-        }
-        llvm::BasicBlock* parent = callSite.getParent();
-        llvm::Loop* loop = loopInfo->getLoopFor(parent);
-        if (loop) {
+        if (callSite.loopDepth != 0) {
             return true;
         }
     }
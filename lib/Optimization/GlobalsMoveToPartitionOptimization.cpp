@@ -17,6 +17,7 @@ GlobalsMoveToPartitionOptimization(Partition& moveToPartition,
                                    Logger& logger)
     : PartitionOptimization(moveToPartition, pdg, logger, PartitionOptimizer::GLOBALS_MOVE_TO)
     , m_globals(outsideUses)
+    , m_movedGlobals(moveToPartition.getGlobals().getIndex())
 {
 }
 
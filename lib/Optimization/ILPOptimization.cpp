@@ -1,7 +1,11 @@
 #include "Optimization/ILPOptimization.h"
 
 #include "Analysis/CallGraph.h"
+#include "Analysis/LibraryCalls.h"
+#include "Analysis/ModuleFacts.h"
 #include "Analysis/Partition.h"
+#include "Analysis/PerformanceHints.h"
+#include "Analysis/PreviousPartition.h"
 #include "Utils/Logger.h"
 
 #include "llvm/IR/Function.h"
@@ -20,6 +24,9 @@ public:
     Impl(const CallGraph& callgraph,
          Partition& securePartition,
          Partition& insecurePartition,
+         const ModuleFacts& moduleFacts,
+         const PerformanceHints& hints,
+         const PreviousPartition& previousPartition,
          Logger& logger);
 
 public:
@@ -31,12 +38,17 @@ private:
     void createEdgeVariables();
     void createEdgeVariables(Node* node);
     void createConstraints();
+    bool canColocate(llvm::Function* caller, llvm::Function* callee) const;
     void createObjective();
+    void addPreviousPartitionStart();
 
 private:
     const CallGraph& m_callgraph;
     Partition& m_securePartition;
     Partition& m_insecurePartition;
+    const ModuleFacts& m_moduleFacts;
+    const PerformanceHints& m_hints;
+    const PreviousPartition& m_previousPartition;
     Logger& m_logger;
 
     IloEnv m_ilpEnv;
@@ -51,13 +63,20 @@ private:
 ILPOptimization::Impl::Impl(const CallGraph& callgraph,
                             Partition& securePartition,
                             Partition& insecurePartition,
+                            const ModuleFacts& moduleFacts,
+                            const PerformanceHints& hints,
+                            const PreviousPartition& previousPartition,
                             Logger& logger)
     : m_callgraph(callgraph)
     , m_securePartition(securePartition)
     , m_insecurePartition(insecurePartition)
+    , m_moduleFacts(moduleFacts)
+    , m_hints(hints)
+    , m_previousPartition(previousPartition)
     , m_logger(logger)
     , m_ilpModel(m_ilpEnv)
     , m_cplex(m_ilpModel)
+    , m_movedFunctions(securePartition.getPartition().getIndex())
 {
 }
 
@@ -67,6 +86,9 @@ void ILPOptimization::Impl::run()
     createEdgeVariables();
     createConstraints();
     createObjective();
+    if (!m_previousPartition.empty()) {
+        addPreviousPartitionStart();
+    }
     m_logger.info("Exporting ILP model to partition_model.lp file");
     m_cplex.exportModel("partition_model.lp");
 
@@ -89,6 +111,9 @@ void ILPOptimization::Impl::apply()
 {
     m_logger.info("Applying ILP optimization");
     for (auto* F : m_movedFunctions) {
+        if (F->isDeclaration()) {
+            continue;
+        }
         m_securePartition.addToPartition(F);
         m_securePartition.removeRelatedFunction(F);
         m_insecurePartition.removeFromPartition(F);
@@ -131,12 +156,21 @@ void ILPOptimization::Impl::createEdgeVariables(Node* node)
 
 void ILPOptimization::Impl::createConstraints()
 {
+    const auto& libraryCalls = LibraryCalls::get();
     for (const auto& [node, var] : m_nodeVariables) {
         auto* F = node->getFunction();
         if (m_securePartition.contains(F)) {
             m_ilpModel.add(var <= 1);
             m_ilpModel.add(var >= 1);
-        } else if (F->isDeclaration() || F->getName() == "main") {
+        } else if (F->getName() == "main" || m_hints.isPinnedUntrusted(F)) {
+            m_ilpModel.add(var <= 0);
+        } else if (F->isDeclaration()) {
+            // Enclave safe library functions are in both partitions, their edges have no weight
+            if (!libraryCalls.isEnclaveSafe(F)) {
+                m_ilpModel.add(var <= 0);
+            }
+        } else if (m_moduleFacts.callsForbiddenFunction(F)) {
+            // Callers of forbidden functions can not run in the enclave
             m_ilpModel.add(var <= 0);
         }
     }
@@ -145,7 +179,29 @@ void ILPOptimization::Impl::createConstraints()
         const auto& sink_var = m_nodeVariables.find(edge->getSink())->second;
         m_ilpModel.add(var - source_var + sink_var <= 1);
         m_ilpModel.add(var + source_var - sink_var <= 1);
+        // Edge variable is 1 only if both ends are in the same partition
+        auto* caller = edge->getSource()->getFunction();
+        auto* callee = edge->getSink()->getFunction();
+        if (m_hints.isLatencyCritical(caller, callee) && canColocate(caller, callee)) {
+            m_ilpModel.add(var >= 1);
+        }
+    }
+}
+
+bool ILPOptimization::Impl::canColocate(llvm::Function* caller, llvm::Function* callee) const
+{
+    // Constraints fixing both ends to different partitions would make the model infeasible
+    const auto& isFixedOutside = [this] (llvm::Function* F) {
+        return m_hints.isPinnedUntrusted(F) || F->getName() == "main"
+            || (F->isDeclaration() && !LibraryCalls::get().isEnclaveSafe(F));
+    };
+    if (m_securePartition.contains(caller)) {
+        return !isFixedOutside(callee);
+    }
+    if (m_securePartition.contains(callee)) {
+        return !isFixedOutside(caller);
     }
+    return true;
 }
 
 void ILPOptimization::Impl::createObjective()
@@ -158,24 +214,53 @@ void ILPOptimization::Impl::createObjective()
     for (const auto& [node, var] : m_nodeVariables) {
         Double sensitiveRelatedCost;
         Double sizeCost;
+        Double memoryCost;
         if (node->getWeight().hasFactor(WeightFactor::SENSITIVE_RELATED)) {
             sensitiveRelatedCost = node->getWeight().getFactor(WeightFactor::SENSITIVE_RELATED).getWeight();
         }
         if (node->getWeight().hasFactor(WeightFactor::SIZE)) {
             sizeCost =  node->getWeight().getFactor(WeightFactor::SIZE).getWeight();
         }
-        const auto& nodeCost = sensitiveRelatedCost - sizeCost;
+        if (node->getWeight().hasFactor(WeightFactor::MEMORY_INTENSITY)) {
+            memoryCost = node->getWeight().getFactor(WeightFactor::MEMORY_INTENSITY).getWeight();
+        }
+        // Churn penalty |var - previous| is linear in var as previous placement is constant
+        const Double churnCost = m_previousPartition.getMoveToEnclaveCost(node->getFunction());
+        const auto& nodeCost = sensitiveRelatedCost - sizeCost - memoryCost - churnCost;
         obj.setLinearCoef(var, nodeCost);
     }
     m_ilpModel.add(obj);
 }
 
+void ILPOptimization::Impl::addPreviousPartitionStart()
+{
+    // Previous placement is a near optimal solution when few annotations changed, the solver repairs it if infeasible
+    IloNumVarArray startVars(m_ilpEnv);
+    IloNumArray startVals(m_ilpEnv);
+    for (const auto& [node, var] : m_nodeVariables) {
+        auto* F = node->getFunction();
+        if (m_securePartition.contains(F)) {
+            startVars.add(var);
+            startVals.add(1);
+        } else if (m_previousPartition.hasFunction(F)) {
+            startVars.add(var);
+            startVals.add(m_previousPartition.wasSecure(F) ? 1 : 0);
+        }
+    }
+    m_cplex.addMIPStart(startVars, startVals, IloCplex::MIPStartRepair);
+    startVars.end();
+    startVals.end();
+}
+
 ILPOptimization::ILPOptimization(const CallGraph& callgraph,
                                  Partition& securePartition,
                                  Partition& insecurePartition,
+                                 const ModuleFacts& moduleFacts,
+                                 const PerformanceHints& hints,
+                                 const PreviousPartition& previousPartition,
                                  Logger& logger)
     : PartitionOptimization(securePartition, nullptr, logger, PartitionOptimizer::ILP)
-    , m_impl(new Impl(callgraph, securePartition, insecurePartition, logger))
+    , m_impl(new Impl(callgraph, securePartition, insecurePartition, moduleFacts, hints, previousPartition, logger))
 {
 }
 
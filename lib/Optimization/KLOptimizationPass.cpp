@@ -2,6 +2,7 @@
 
 #include "Analysis/CallGraph.h"
 #include "Analysis/Partition.h"
+#include "Analysis/PreviousPartition.h"
 #include "Utils/Logger.h"
 
 #include "llvm/IR/Function.h"
@@ -18,6 +19,7 @@ public:
     Impl(const CallGraph& callgraph,
          Partition& securePartition,
          Partition& insecurePartition,
+         const PreviousPartition& previousPartition,
          Logger& logger);
 
 public:
@@ -37,6 +39,7 @@ private:
     const CallGraph& m_callgraph;
     Partition& m_securePartition;
     Partition& m_insecurePartition;
+    const PreviousPartition& m_previousPartition;
     Logger& m_logger;
     Functions m_candidates;
     std::vector<Double> m_moveGains;
@@ -50,10 +53,12 @@ private:
 KLOptimizationPass::Impl::Impl(const CallGraph& callgraph,
                                Partition& securePartition,
                                Partition& insecurePartition,
+                               const PreviousPartition& previousPartition,
                                Logger& logger)
     : m_callgraph(callgraph)
     , m_securePartition(securePartition)
     , m_insecurePartition(insecurePartition)
+    , m_previousPartition(previousPartition)
     , m_logger(logger)
 {
 }
@@ -110,8 +115,13 @@ void KLOptimizationPass::Impl::computeNodeCosts()
             Fnode->getWeight().getFactor(WeightFactor::SENSITIVE_RELATED).getWeight() : Double();
         const auto& sizeFactor =  Fnode->getWeight().hasFactor(WeightFactor::SIZE) ?
             Fnode->getWeight().getFactor(WeightFactor::SIZE).getWeight() : Double();
-        // The sensitive related needs to be optimized, while the size (TCB) needs to be minimized
-        m_functionCosts.insert(std::make_pair(F, sensitiveRelatedFactor + (-1) * sizeFactor));
+        const auto& memoryFactor = Fnode->getWeight().hasFactor(WeightFactor::MEMORY_INTENSITY) ?
+            Fnode->getWeight().getFactor(WeightFactor::MEMORY_INTENSITY).getWeight() : Double();
+        // Moving a function back to where it was in the previous run gains the churn penalty.
+        // KL starts from the current partition, the penalty is the only pull towards the previous one
+        const Double churnGain = -m_previousPartition.getMoveToEnclaveCost(F);
+        // The sensitive related needs to be optimized, while the size (TCB) and in-enclave slowdown need to be minimized
+        m_functionCosts.insert(std::make_pair(F, sensitiveRelatedFactor + (-1) * sizeFactor + (-1) * memoryFactor + churnGain));
     }
 }
 
@@ -203,8 +213,9 @@ void KLOptimizationPass::Impl::applyOptimization()
 KLOptimizationPass::KLOptimizationPass(const CallGraph& callgraph,
                                        Partition& securePartition,
                                        Partition& insecurePartition,
+                                       const PreviousPartition& previousPartition,
                                        Logger& logger)
-    : m_impl(new Impl(callgraph, securePartition, insecurePartition, logger))
+    : m_impl(new Impl(callgraph, securePartition, insecurePartition, previousPartition, logger))
 {
 }
 
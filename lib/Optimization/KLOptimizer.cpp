@@ -1,7 +1,9 @@
 #include "Optimization/KLOptimizer.h"
 
 #include "Analysis/CallGraph.h"
+#include "Analysis/ModuleFacts.h"
 #include "Analysis/Partition.h"
+#include "Analysis/PerformanceHints.h"
 #include "Optimization/KLOptimizationPass.h"
 #include "Utils/PartitionUtils.h"
 #include "Utils/Logger.h"
@@ -19,6 +21,9 @@ public:
          const pdg::PDG& pdg,
          Partition& securePartition,
          Partition& insecurePartition,
+         const ModuleFacts& moduleFacts,
+         const PerformanceHints& hints,
+         const PreviousPartition& previousPartition,
          Logger& logger);
 
 public:
@@ -32,6 +37,9 @@ private:
     const pdg::PDG& m_pdg;
     Partition& m_securePartition;
     Partition& m_insecurePartition;
+    const ModuleFacts& m_moduleFacts;
+    const PerformanceHints& m_hints;
+    const PreviousPartition& m_previousPartition;
     Logger& m_logger;
 }; // class KLOptimizer::Impl
 
@@ -39,11 +47,17 @@ KLOptimizer::Impl::Impl(const CallGraph& callgraph,
                         const pdg::PDG& pdg,
                         Partition& securePartition,
                         Partition& insecurePartition,
+                        const ModuleFacts& moduleFacts,
+                        const PerformanceHints& hints,
+                        const PreviousPartition& previousPartition,
                         Logger& logger)
     : m_callGraph(callgraph)
     , m_pdg(pdg)
     , m_securePartition(securePartition)
     , m_insecurePartition(insecurePartition)
+    , m_moduleFacts(moduleFacts)
+    , m_hints(hints)
+    , m_previousPartition(previousPartition)
     , m_logger(logger)
 {
 }
@@ -52,7 +66,7 @@ void KLOptimizer::Impl::run()
 {
     m_logger.info("Running Kernighan-Lin optimization");
     const auto& passCandidates = collectPassCandidates();
-    KLOptimizationPass klOptPass(m_callGraph, m_securePartition, m_insecurePartition, m_logger);
+    KLOptimizationPass klOptPass(m_callGraph, m_securePartition, m_insecurePartition, m_previousPartition, m_logger);
 
     // One pass should be enough
     //while (true) {
@@ -70,7 +84,8 @@ KLOptimizationPass::Functions KLOptimizer::Impl::collectPassCandidates() const
 {
     KLOptimizationPass::Functions passCandidates;
     for (auto F : m_insecurePartition.getPartition()) {
-        if (!F->isDeclaration() && !F->isIntrinsic() && F->getName() != "main") {
+        if (!F->isDeclaration() && !F->isIntrinsic() && F->getName() != "main"
+                && !m_hints.isPinned(F) && !m_moduleFacts.callsForbiddenFunction(F)) {
             passCandidates.push_back(F);
         }
     }
@@ -81,9 +96,12 @@ KLOptimizer::KLOptimizer(const CallGraph& callgraph,
                          PDGType pdg,
                          Partition& securePartition,
                          Partition& insecurePartition,
+                         const ModuleFacts& moduleFacts,
+                         const PerformanceHints& hints,
+                         const PreviousPartition& previousPartition,
                          Logger& logger)
     : PartitionOptimization(securePartition, pdg, logger, PartitionOptimizer::KERNIGHAN_LIN)
-    , m_impl(new Impl(callgraph, *pdg, securePartition, insecurePartition, logger))
+    , m_impl(new Impl(callgraph, *pdg, securePartition, insecurePartition, moduleFacts, hints, previousPartition, logger))
 {
 }
 
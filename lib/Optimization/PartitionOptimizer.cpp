@@ -6,33 +6,35 @@
 #include "Optimization/KLOptimizer.h"
 #include "Optimization/StaticAnalysisOptimization.h"
 #include "Optimization/ILPOptimization.h"
+#include "Analysis/PerformanceHints.h"
+#include "Analysis/PreviousPartition.h"
 #include "Utils/PartitionUtils.h"
 #include "Utils/Logger.h"
 
 #include "PDG/PDG/PDG.h"
 
-#include "llvm/Analysis/LoopInfo.h"
-
 namespace vazgen {
 
 PartitionOptimizer::PartitionOptimizer(Partition& securePartition,
                                        Partition& insecurePartition,
                                        PDGType pdg,
                                        const CallGraph& callgraph,
+                                       const ModuleFacts& moduleFacts,
+                                       const PerformanceHints& hints,
+                                       const PreviousPartition& previousPartition,
                                        Logger& logger)
     : m_securePartition(securePartition)
     , m_insecurePartition(insecurePartition)
     , m_pdg(pdg)
     , m_callgraph(callgraph)
+    , m_moduleFacts(moduleFacts)
+    , m_hints(hints)
+    , m_previousPartition(previousPartition)
     , m_logger(logger)
+    , m_sensitiveFunctions(securePartition.getPartition())
 {
 }
 
-void PartitionOptimizer::setLoopInfoGetter(const LoopInfoGetter& loopInfoGetter)
-{
-    m_loopInfoGetter = loopInfoGetter;
-}
-
 void PartitionOptimizer::run(const Optimizations& opts)
 {
     for (auto opt : opts) {
@@ -57,17 +59,19 @@ PartitionOptimizer::getOptimizerFor(PartitionOptimizer::Optimization opt,
 {
     switch (opt) {
     case PartitionOptimizer::FUNCTIONS_MOVE_TO:
-        return std::make_shared<FunctionsMoveToPartitionOptimization>(partition, m_pdg, m_logger, m_loopInfoGetter);
+        return std::make_shared<FunctionsMoveToPartitionOptimization>(partition, m_pdg, m_moduleFacts, m_hints, m_logger);
     case PartitionOptimizer::GLOBALS_MOVE_TO:
         return std::make_shared<GlobalsMoveToPartitionOptimization>(partition, complementPart.getGlobals(), m_pdg, m_logger);
     case PartitionOptimizer::DUPLICATE_FUNCTIONS:
         return std::make_shared<DuplicateFunctionsOptimization>(partition, m_logger);
     case KERNIGHAN_LIN:
-        return std::make_shared<KLOptimizer>(m_callgraph, m_pdg, m_securePartition, m_insecurePartition, m_logger);
+        return std::make_shared<KLOptimizer>(m_callgraph, m_pdg, m_securePartition, m_insecurePartition, m_moduleFacts,
+                                             m_hints, m_previousPartition, m_logger);
     case STATIC_ANALYSIS:
         return std::make_shared<StaticAnalysisOptimization>(m_securePartition, m_logger);
     case ILP:
-        return std::make_shared<ILPOptimization>(m_callgraph, m_securePartition, m_insecurePartition, m_logger);
+        return std::make_shared<ILPOptimization>(m_callgraph, m_securePartition, m_insecurePartition, m_moduleFacts,
+                                                 m_hints, m_previousPartition, m_logger);
     default:
         break;
     }
@@ -94,14 +98,19 @@ void PartitionOptimizer::apply()
     for (auto opt : m_optimizations) {
         opt->apply();
     }
+    m_insecurePartition.removeFromPartition(m_securePartition.getPartition());
     for (auto* F : m_securePartition.getPartition()) {
-        m_insecurePartition.removeFromPartition(F);
         m_securePartition.removeRelatedFunction(F);
     }
-    m_securePartition.setInInterface(PartitionUtils::computeInInterface(m_securePartition.getPartition(), *m_pdg));
-    m_securePartition.setOutInterface(PartitionUtils::computeOutInterface(m_securePartition.getPartition(), *m_pdg));
-    m_insecurePartition.setInInterface(PartitionUtils::computeInInterface(m_insecurePartition.getPartition(), *m_pdg));
-    m_insecurePartition.setOutInterface(PartitionUtils::computeOutInterface(m_insecurePartition.getPartition(), *m_pdg));
+    // Optimizations not aware of hints, e.g. static analysis, may have broken them
+    m_hints.enforce(m_securePartition, m_insecurePartition, m_sensitiveFunctions);
+    if (!m_previousPartition.empty()) {
+        const unsigned moved = m_previousPartition.getMovedFunctionsNum(m_securePartition, m_insecurePartition);
+        m_logger.info(std::to_string(moved) + " functions placed differently than in the previous partition");
+    }
+    // interfaces have been maintained by the partitions while functions were moved
+    PartitionUtils::verifyInterfaces(m_securePartition, *m_pdg, m_logger);
+    PartitionUtils::verifyInterfaces(m_insecurePartition, *m_pdg, m_logger);
 }
 
 } // namespace vazgen
@@ -0,0 +1,160 @@
+#include "Transforms/FunctionLayout.h"
+
+#include "Analysis/CallProfile.h"
+#include "Analysis/ModuleFacts.h"
+#include "Analysis/Partition.h"
+#include "Utils/Logger.h"
+
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <unordered_set>
+
+extern llvm::cl::opt<std::string> Profile;
+
+namespace vazgen {
+
+namespace {
+
+// Share of all function entries hot functions account for
+const double HOT_ENTRIES_SHARE = 0.9;
+// Functions entered at most this many times per run, e.g. initialization code.
+// Functions with no estimate have 0 entries, those are not taken as cold
+const double COLD_ENTRIES = 1;
+const long PAGE_SIZE = 4096;
+
+const std::string HOT_SECTION = ".text.hot";
+const std::string COLD_SECTION = ".text.unlikely";
+
+}
+
+FunctionLayout::FunctionLayout(llvm::Module& extractedModule,
+                               llvm::Module& originalModule,
+                               const ModuleFacts& moduleFacts,
+                               const Partition& partition,
+                               Logger& logger)
+    : m_extractedModule(extractedModule)
+    , m_originalModule(originalModule)
+    , m_moduleFacts(moduleFacts)
+    , m_partition(partition)
+    , m_logger(logger)
+{
+}
+
+void FunctionLayout::apply()
+{
+    collectFunctionInfos();
+    if (m_functionInfos.empty()) {
+        return;
+    }
+    std::vector<FunctionInfo*> originalOrder;
+    for (auto& info : m_functionInfos) {
+        originalOrder.push_back(&info);
+    }
+    std::vector<FunctionInfo*> hotOrder = originalOrder;
+    std::stable_sort(hotOrder.begin(), hotOrder.end(),
+            [] (FunctionInfo* info1, FunctionInfo* info2) { return info1->entries > info2->entries; });
+    const double totalEntries = std::accumulate(m_functionInfos.begin(), m_functionInfos.end(), 0.0,
+            [] (double sum, const FunctionInfo& info) { return sum + info.entries; });
+
+    // Hot prefix, then functions in their original order, then cold ones
+    m_isHot.assign(m_functionInfos.size(), false);
+    std::vector<FunctionInfo*> layout;
+    std::unordered_set<FunctionInfo*> placed;
+    double hotEntries = 0;
+    for (auto* info : hotOrder) {
+        if (hotEntries >= HOT_ENTRIES_SHARE * totalEntries || info->entries <= COLD_ENTRIES) {
+            break;
+        }
+        // Sections set in the source are kept
+        if (info->function->hasSection()) {
+            continue;
+        }
+        hotEntries += info->entries;
+        m_isHot[info - m_functionInfos.data()] = true;
+        info->function->setSection(HOT_SECTION);
+        layout.push_back(info);
+        placed.insert(info);
+    }
+    std::vector<FunctionInfo*> coldFunctions;
+    for (auto* info : originalOrder) {
+        if (placed.find(info) != placed.end()) {
+            continue;
+        }
+        if (info->canBeCold && info->entries <= COLD_ENTRIES && !info->function->hasSection()) {
+            info->function->setSection(COLD_SECTION);
+            coldFunctions.push_back(info);
+        } else {
+            layout.push_back(info);
+        }
+    }
+    layout.insert(layout.end(), coldFunctions.begin(), coldFunctions.end());
+
+    const unsigned hotPagesBefore = getHotPagesNum(originalOrder);
+    auto& functionList = m_extractedModule.getFunctionList();
+    for (auto* info : layout) {
+        functionList.splice(functionList.end(), functionList, info->function->getIterator());
+    }
+    m_logger.info("Enclave layout: " + std::to_string(placed.size()) + " hot and "
+                  + std::to_string(coldFunctions.size()) + " cold functions, hot working set of "
+                  + std::to_string(hotPagesBefore) + " pages before and "
+                  + std::to_string(getHotPagesNum(layout)) + " pages after");
+}
+
+void FunctionLayout::collectFunctionInfos()
+{
+    std::unique_ptr<CallProfile> callProfile;
+    if (!Profile.empty()) {
+        callProfile = std::make_unique<CallProfile>(m_logger);
+        if (!callProfile->load(Profile)) {
+            callProfile.reset();
+        }
+    }
+    for (auto& F : m_extractedModule) {
+        if (F.isDeclaration()) {
+            continue;
+        }
+        llvm::Function* originalF = m_originalModule.getFunction(F.getName());
+        if (!originalF) {
+            // Functions created during extraction, e.g. global setters, have no facts
+            m_functionInfos.push_back(FunctionInfo{&F, 0, 0, false});
+            continue;
+        }
+        double entries = m_moduleFacts.getFunctionFrequency(originalF);
+        if (callProfile && callProfile->hasFunction(originalF)) {
+            entries = callProfile->getEntriesNum(originalF);
+        }
+        const bool canBeCold = entries > 0 && !isEntryPoint(originalF);
+        m_functionInfos.push_back(FunctionInfo{&F, entries, m_moduleFacts.getCodeSize(originalF), canBeCold});
+    }
+}
+
+bool FunctionLayout::isEntryPoint(llvm::Function* originalF) const
+{
+    // Entries of ecalls, main and callback roots are guessed, not estimated from their call sites
+    return m_partition.getInInterface().contains(originalF)
+        || originalF->getName() == "main"
+        || m_moduleFacts.getCallSites(originalF).empty();
+}
+
+unsigned FunctionLayout::getHotPagesNum(const std::vector<FunctionInfo*>& order) const
+{
+    std::unordered_set<long> pages;
+    long offset = 0;
+    for (auto* info : order) {
+        if (m_isHot[info - m_functionInfos.data()] && info->codeSize != 0) {
+            for (long page = offset / PAGE_SIZE; page <= (offset + info->codeSize - 1) / PAGE_SIZE; ++page) {
+                pages.insert(page);
+            }
+        }
+        offset += info->codeSize;
+    }
+    return pages.size();
+}
+
+} // namespace vazgen
+
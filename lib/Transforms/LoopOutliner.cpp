@@ -0,0 +1,164 @@
+#include "Transforms/LoopOutliner.h"
+
+#include "Analysis/LibraryCalls.h"
+#include "Analysis/Partition.h"
+#include "Analysis/ProgramPartitionAnalysis.h"
+#include "Utils/Logger.h"
+
+#include "llvm/Analysis/BlockFrequencyInfo.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Transforms/Utils/CodeExtractor.h"
+
+#include <utility>
+#include <vector>
+
+namespace vazgen {
+
+namespace {
+
+// Enclave calls per iteration for the loop to be worth an ecall of its own
+const double MIN_CROSSINGS_PER_ITERATION = 0.5;
+// Calls that would leave the enclave, relative to the calls into it
+const double MAX_NEW_CROSSINGS_SHARE = 0.1;
+
+}
+
+LoopOutliner::LoopOutliner(const Partition& securePartition, Logger& logger)
+    : m_securePartition(securePartition)
+    , m_logger(logger)
+{
+}
+
+std::vector<LoopOutliner::Blocks> LoopOutliner::findLoops(const llvm::LoopInfo& loopInfo,
+                                                          const llvm::BlockFrequencyInfo& blockFrequency) const
+{
+    std::vector<Blocks> loops;
+    for (auto* loop : loopInfo) {
+        findLoops(loop, blockFrequency, loops);
+    }
+    return loops;
+}
+
+void LoopOutliner::findLoops(llvm::Loop* loop,
+                             const llvm::BlockFrequencyInfo& blockFrequency,
+                             std::vector<Blocks>& loops) const
+{
+    if (isCrossingLoop(loop, blockFrequency)) {
+        Blocks blocks(loop->getBlocks().begin(), loop->getBlocks().end());
+        if (llvm::CodeExtractor(blocks).isEligible()) {
+            loops.push_back(std::move(blocks));
+            return;
+        }
+    }
+    // Inner loop may cross on every iteration while the outer one also calls outside
+    for (auto* subloop : *loop) {
+        findLoops(subloop, blockFrequency, loops);
+    }
+}
+
+bool LoopOutliner::isCrossingLoop(llvm::Loop* loop, const llvm::BlockFrequencyInfo& blockFrequency) const
+{
+    // Outlined loop is entered from its preheader, the only block outside branching to the header
+    if (!loop->getLoopPreheader()) {
+        return false;
+    }
+    const auto& libraryCalls = LibraryCalls::get();
+    double crossings = 0;
+    double newCrossings = 0;
+    for (auto* B : loop->getBlocks()) {
+        const double frequency = blockFrequency.getBlockFreq(B).getFrequency();
+        for (auto& I : *B) {
+            llvm::CallSite callSite(&I);
+            if (!callSite || llvm::isa<llvm::IntrinsicInst>(&I)) {
+                continue;
+            }
+            auto* callee = callSite.getCalledFunction();
+            if (callee && libraryCalls.isForbidden(callee)) {
+                return false;
+            }
+            if (callee && m_securePartition.contains(callee)) {
+                crossings += frequency;
+            } else if (!callee || !libraryCalls.isEnclaveSafe(callee)) {
+                // Indirect calls, calls to untrusted functions and library calls needing ocalls leave the enclave.
+                // Enclave safe library functions are linked into the enclave and run there
+                newCrossings += frequency;
+            }
+        }
+    }
+    const double headerFrequency = blockFrequency.getBlockFreq(loop->getHeader()).getFrequency();
+    if (crossings == 0 || crossings < headerFrequency * MIN_CROSSINGS_PER_ITERATION) {
+        return false;
+    }
+    return newCrossings <= crossings * MAX_NEW_CROSSINGS_SHARE;
+}
+
+unsigned LoopOutliner::outline(llvm::Function* F, const std::vector<Blocks>& loops)
+{
+    unsigned outlined = 0;
+    for (const auto& blocks : loops) {
+        llvm::CodeExtractor extractor(blocks);
+        if (!extractor.isEligible()) {
+            continue;
+        }
+        auto* outlinedF = extractor.extractCodeRegion();
+        if (!outlinedF) {
+            m_logger.warn("Failed to outline loop of " + F->getName().str());
+            continue;
+        }
+        m_logger.info("Outlined enclave calling loop " + outlinedF->getName().str()
+                      + " from " + F->getName().str());
+        ++outlined;
+    }
+    return outlined;
+}
+
+char LoopOutlinerPass::ID = 0;
+
+void LoopOutlinerPass::getAnalysisUsage(llvm::AnalysisUsage& AU) const
+{
+    AU.addRequired<ProgramPartitionAnalysis>();
+    AU.addRequired<llvm::LoopInfoWrapperPass>();
+    AU.addRequired<llvm::BlockFrequencyInfoWrapperPass>();
+}
+
+bool LoopOutlinerPass::runOnModule(llvm::Module& M)
+{
+    Logger logger("loop-outliner");
+    logger.setLevel(vazgen::Logger::INFO);
+
+    const auto& securePartition = getAnalysis<ProgramPartitionAnalysis>().getProgramPartition().getSecurePartition();
+    LoopOutliner outliner(securePartition, logger);
+
+    // Loops are found before any is outlined, as outlined functions are added to the module
+    std::vector<std::pair<llvm::Function*, std::vector<LoopOutliner::Blocks>>> functionLoops;
+    for (auto& F : M) {
+        if (F.isDeclaration() || securePartition.contains(&F)) {
+            continue;
+        }
+        // Loop info and block frequencies are recomputed in place for the next function,
+        // so loop blocks are collected here and outlining works on blocks only
+        auto& loopPass = getAnalysis<llvm::LoopInfoWrapperPass>(F);
+        auto& blockFrequencyPass = getAnalysis<llvm::BlockFrequencyInfoWrapperPass>(F);
+        auto loops = outliner.findLoops(loopPass.getLoopInfo(), blockFrequencyPass.getBFI());
+        if (!loops.empty()) {
+            functionLoops.push_back(std::make_pair(&F, std::move(loops)));
+        }
+    }
+    unsigned outlined = 0;
+    for (const auto& [F, loops] : functionLoops) {
+        outlined += outliner.outline(F, loops);
+    }
+    logger.info("Outlined " + std::to_string(outlined) + " loops calling into the enclave. "
+                "Partition again with -optimize to place them");
+    return outlined != 0;
+}
+
+static llvm::RegisterPass<LoopOutlinerPass> X("outline-crossing-loops","Outline untrusted loops calling the enclave on every iteration");
+
+} // namespace vazgen
+
@@ -1,9 +1,13 @@
 #include "Transforms/PartitionExtractor.h"
 
+#include "Analysis/EnclaveSizing.h"
+#include "Analysis/LibraryCalls.h"
 #include "Analysis/Partitioner.h"
 #include "Analysis/ProgramPartitionAnalysis.h"
+#include "Transforms/FunctionLayout.h"
 #include "Utils/Utils.h"
 #include "Utils/Logger.h"
+#include "Utils/PartitionUtils.h"
 #include "Utils/Statistics.h"
 
 #include "PDG/Passes/PDGBuildPasses.h"
@@ -30,25 +34,13 @@
 
 #include <algorithm>
 #include <iterator>
-#include <list>
+#include <unordered_set>
+#include <vector>
 
 namespace vazgen {
 
 namespace {
 
-void addReachableNodes(pdg::PDGNode* node, std::list<pdg::PDGNode*>& list)
-{
-    for (auto it = node->outEdgesBegin();
-         it != node->outEdgesEnd();
-         ++it) {
-        if ((*it)->isControlEdge()) {
-            continue;
-        }
-         auto* destNode = (*it)->getDestination().get();
-         list.push_front(destNode);
-    }
-}
-
 class GlobalVariableExtractorHelper
 {
 public:
@@ -76,7 +68,10 @@ public:
     }
 
 private:
-    void addGlobalSetter(llvm::GlobalVariable* global);
+    using StoreSites = std::vector<llvm::StoreInst*>;
+
+    StoreSites collectStoreSites(llvm::GlobalVariable* global) const;
+    void addGlobalSetter(llvm::GlobalVariable* global, const StoreSites& stores);
     void addGlobalSetterAfter(llvm::Instruction* instr, llvm::GlobalVariable* global);
     void createGlobalSetterFunction(llvm::GlobalVariable* global);
 
@@ -104,37 +99,55 @@ GlobalVariableExtractorHelper::GlobalVariableExtractorHelper(llvm::Module* M,
 
 void GlobalVariableExtractorHelper::instrumentForGlobals()
 {
+    std::vector<llvm::GlobalVariable*> globals;
     for (auto* global : m_partition.getGlobals()) {
-        addGlobalSetter(global);
+        if (!m_pdg.hasGlobalVariableNode(global)) {
+            m_logger.warn("No pdg node for global " + global->getName().str());
+            continue;
+        }
+        globals.push_back(global);
+    }
+    // Store sites are collected in parallel, as it only reads the module.
+    // Instrumentation modifies the module, hence is done sequentially afterwards.
+    std::vector<StoreSites> storeSites(globals.size());
+    PartitionUtils::parallelFor(globals.size(), PartitionUtils::GLOBALS_SHARD_SIZE,
+            [&] (unsigned begin, unsigned end, unsigned shard) {
+                for (unsigned i = begin; i < end; ++i) {
+                    storeSites[i] = collectStoreSites(globals[i]);
+                }
+            });
+    for (unsigned i = 0; i < globals.size(); ++i) {
+        addGlobalSetter(globals[i], storeSites[i]);
     }
 }
 
-void GlobalVariableExtractorHelper::addGlobalSetter(llvm::GlobalVariable* global)
+// Setters are needed after direct stores to the global. Those are exactly the store users of the global,
+// so the use list gives all of them without traversing the PDG.
+GlobalVariableExtractorHelper::StoreSites
+GlobalVariableExtractorHelper::collectStoreSites(llvm::GlobalVariable* global) const
 {
-    if (!m_pdg.hasGlobalVariableNode(global)) {
-        m_logger.warn("No pdg node for global " + global->getName().str());
-        return;
-    }
-    auto globalNode = m_pdg.getGlobalVariableNode(global);
-    std::list<pdg::PDGNode*> worklist;
-    worklist.push_back(globalNode.get());
-    while (!worklist.empty()) {
-        pdg::PDGNode* currentNode = worklist.back();
-        worklist.pop_back();
-        auto* llvmNode = llvm::dyn_cast<pdg::PDGLLVMInstructionNode>(currentNode);
-        if (!llvmNode) {
-            addReachableNodes(currentNode, worklist);
+    StoreSites stores;
+    std::unordered_set<llvm::StoreInst*> processedStores;
+    for (auto* user : global->users()) {
+        auto* storeInst = llvm::dyn_cast<llvm::StoreInst>(user);
+        if (!storeInst || storeInst->getPointerOperand() != global) {
             continue;
         }
-        auto* nodeValue = llvmNode->getNodeValue();
-        assert(nodeValue);
-        if (auto* storeInst = llvm::dyn_cast<llvm::StoreInst>(nodeValue)) {
-            if (storeInst->getPointerOperand() == global
-                    && m_partition.contains(storeInst->getFunction())) {
-                addGlobalSetterAfter(storeInst, global);
-            }
+        if (!m_partition.contains(storeInst->getFunction())) {
+            continue;
         }
-        addReachableNodes(currentNode, worklist);
+        // the global may be both the pointer and the value operand of the same store
+        if (processedStores.insert(storeInst).second) {
+            stores.push_back(storeInst);
+        }
+    }
+    return stores;
+}
+
+void GlobalVariableExtractorHelper::addGlobalSetter(llvm::GlobalVariable* global, const StoreSites& stores)
+{
+    for (auto* storeInst : stores) {
+        addGlobalSetterAfter(storeInst, global);
     }
 }
 
@@ -292,16 +305,19 @@ bool PartitionExtractorPass::runOnModule(llvm::Module& M)
     Logger logger("program-partitioning");
     logger.setLevel(vazgen::Logger::INFO);
 
-    const auto& enclaveGloabalSetters = getGlobalSetters(M, logger, true);
-    const auto& appGloabalSetters = getGlobalSetters(M, logger, false);
-    bool modified = extractPartition(logger, M, enclaveGloabalSetters, true);
-    modified |= extractPartition(logger, M, appGloabalSetters, false);
+    ProgramPartition& programPartition = getAnalysis<ProgramPartitionAnalysis>().getProgramPartition();
+    // Setters are not in the function index of ModuleFacts, so they are passed along with the partitions
+    programPartition.setSecureGlobalSetters(getGlobalSetters(M, logger, true));
+    programPartition.setInsecureGlobalSetters(getGlobalSetters(M, logger, false));
+    bool modified = extractPartition(logger, M, programPartition.getSecureGlobalSetters(), true);
+    modified |= extractPartition(logger, M, programPartition.getInsecureGlobalSetters(), false);
     return modified;
 }
 
 PartitionExtractorPass::FunctionSet
 PartitionExtractorPass::getGlobalSetters(llvm::Module& M, Logger& logger, bool isEnclave)
 {
+    // Partition copies are copy-on-write, so this snapshot does not copy the partition sets
     Partition partition;
     std::string prefixName;
     auto pdg = getAnalysis<pdg::SVFGPDGBuilder>().getPDG();
@@ -334,29 +350,45 @@ bool PartitionExtractorPass::extractPartition(Logger& logger, llvm::Module& M,
         partition = &programPartition.getInsecurePartition();
         sliceName = "app_lib.bc";
     }
-    for (const auto& globalSetter : globalSetters) {
-        partition->addToPartition(globalSetter);
-    }
     m_extractor.reset(new PartitionExtractor(&M, *partition, globalSetters, logger));
     bool modified = m_extractor->extract();
     if (modified) {
         logger.info("Extraction done\n");
         if (enclave) {
-            renameInsecureCalls("insecure_", m_extractor->getSlicedModule().get(), programPartition.getInsecurePartition());
+            renameInsecureCalls(logger, "insecure_", m_extractor->getSlicedModule().get(), programPartition.getInsecurePartition());
+            FunctionLayout layout(*m_extractor->getSlicedModule(), M, programPartition.getModuleFacts(),
+                                  programPartition.getSecurePartition(), logger);
+            layout.apply();
         }
         Utils::saveModule(m_extractor->getSlicedModule().get(), sliceName);
+        if (enclave) {
+            EnclaveSizing enclaveSizing(*m_extractor->getSlicedModule(), M, programPartition.getModuleFacts(), logger);
+            enclaveSizing.estimate();
+            enclaveSizing.dump("enclave_config.json");
+        }
     } else {
         logger.info("No extraction\n");
     }
     return modified;
 }
 
-void PartitionExtractorPass::renameInsecureCalls(const std::string& prefix, llvm::Module* M, const Partition& insecurePartition)
+void PartitionExtractorPass::renameInsecureCalls(Logger& logger,
+                                                 const std::string& prefix,
+                                                 llvm::Module* M,
+                                                 const Partition& insecurePartition)
 {
+    const auto& libraryCalls = LibraryCalls::get();
     for (auto& F : *M) {
         if (!F.isDeclaration()) {
             continue;
         }
+        // Enclave safe library functions link against the trusted libc and are not turned into ocalls
+        if (libraryCalls.isEnclaveSafe(&F)) {
+            continue;
+        }
+        if (libraryCalls.isForbidden(&F)) {
+            logger.error("Enclave calls forbidden function " + F.getName().str());
+        }
         if (insecurePartition.containsFunctionWithName(F.getName())) {
             F.setName(prefix + F.getName());
         }
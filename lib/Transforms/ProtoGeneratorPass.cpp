@@ -29,8 +29,11 @@ void ProtoGeneratorPass::getAnalysisUsage(llvm::AnalysisUsage& AU) const
 
 bool ProtoGeneratorPass::runOnModule(llvm::Module& M)
 {
-    const auto& partition = getAnalysis<ProgramPartitionAnalysis>().getProgramPartition().getSecurePartition();
-    ProtoFileGenerator protoGen(partition, M.getName().str());
+    const auto& programPartition = getAnalysis<ProgramPartitionAnalysis>().getProgramPartition();
+    // The generator keeps a reference to the name
+    const std::string protoName = M.getName().str();
+    ProtoFileGenerator protoGen(programPartition.getSecurePartition(), programPartition.getSecureGlobalSetters(),
+                                protoName);
     protoGen.generate();
 
     ProtoFileWriter writer(M.getName().str() + "_enclave.proto", protoGen.getProtoFile());
@@ -0,0 +1,375 @@
+#include "Transforms/RegionOutliner.h"
+
+#include "Analysis/ModuleFacts.h"
+#include "Analysis/PDGSnapshot.h"
+#include "Analysis/TransitionCostProfile.h"
+#include "Utils/Annotation.h"
+#include "Utils/AnnotationParser.h"
+#include "Utils/JsonAnnotationParser.h"
+#include "Utils/Logger.h"
+#include "Utils/ModuleAnnotationParser.h"
+#include "Utils/RingBuffer.h"
+
+#include "PDG/PDG/PDG.h"
+#include "PDG/PDG/FunctionPDG.h"
+#include "PDG/Passes/PDGBuildPasses.h"
+
+#include "llvm/ADT/SetVector.h"
+#include "llvm/Analysis/BlockFrequencyInfo.h"
+#include "llvm/Analysis/DominanceFrontier.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/PostDominators.h"
+#include "llvm/Analysis/RegionInfo.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Transforms/Utils/CodeExtractor.h"
+
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+extern llvm::cl::opt<std::string> CostProfile;
+
+llvm::cl::opt<double> OutlineByteNs(
+    "outline-byte-ns",
+    llvm::cl::desc("Nanoseconds of transitions per run one byte of enclave code is worth when outlining regions"),
+    llvm::cl::value_desc("nanoseconds"),
+    llvm::cl::init(50.0));
+
+namespace vazgen {
+
+extern llvm::cl::opt<std::string> JsonAnnotations;
+
+namespace {
+
+// Used without -cost-profile, a round trip ocall of SGX SDK and memcpy over the boundary
+const double DEFAULT_TRANSITION_NS = 8000;
+const double DEFAULT_BYTE_COPY_NS = 0.25;
+// Same estimate of machine code as ModuleFacts
+const long INSTRUCTION_BYTES = 4;
+// Trusted side bridge generated for the ocall of an outlined region
+const long OCALL_STUB_BYTES = 256;
+// Smaller regions are not worth a new function
+const long MIN_SAVED_BYTES = 64;
+
+}
+
+RegionOutliner::RegionOutliner(llvm::Module& M,
+                               PDGType pdg,
+                               const PDGSnapshot& pdgSnapshot,
+                               const ModuleFacts& moduleFacts,
+                               Logger& logger)
+    : m_module(M)
+    , m_pdg(pdg)
+    , m_pdgSnapshot(pdgSnapshot)
+    , m_moduleFacts(moduleFacts)
+    , m_logger(logger)
+    , m_transitionNs(DEFAULT_TRANSITION_NS)
+    , m_byteCopyNs(DEFAULT_BYTE_COPY_NS)
+    , m_savedBytes(0)
+{
+    if (CostProfile.empty()) {
+        return;
+    }
+    TransitionCostProfile costProfile(m_logger);
+    if (costProfile.load(CostProfile)) {
+        m_transitionNs = costProfile.getTransitionNs();
+        m_byteCopyNs = costProfile.getByteCopyNs();
+    }
+}
+
+void RegionOutliner::collectSensitiveInstructions(const Annotation& annotation, InstructionSet& sensitive) const
+{
+    llvm::Function* F = annotation.getFunction();
+    if (!m_pdg->hasFunctionPDG(F)) {
+        return;
+    }
+    auto Fpdg = m_pdg->getFunctionPDG(F);
+    for (auto arg_idx : annotation.getAnnotatedArguments()) {
+        auto* arg = &*(F->arg_begin() + arg_idx);
+        if (!Fpdg->hasFormalArgNode(arg)) {
+            continue;
+        }
+        const unsigned argNode = m_pdgSnapshot.getNodeId(Fpdg->getFormalArgNode(arg).get());
+        if (argNode != PDGSnapshot::INVALID_NODE) {
+            addSlice(argNode, true, F, sensitive);
+        }
+    }
+    // Values stored through annotated arguments are traced back, as PartitionForArguments does
+    std::vector<llvm::Value*> storedValues;
+    for (auto* I : sensitive) {
+        if (auto* store = llvm::dyn_cast<llvm::StoreInst>(I)) {
+            storedValues.push_back(store->getValueOperand());
+        }
+    }
+    if (annotation.isReturnAnnotated()) {
+        for (auto& B : *F) {
+            if (llvm::isa<llvm::ReturnInst>(B.getTerminator())) {
+                storedValues.push_back(B.getTerminator());
+            }
+        }
+    }
+    for (auto* value : storedValues) {
+        if (!Fpdg->hasNode(value)) {
+            continue;
+        }
+        const unsigned valueNode = m_pdgSnapshot.getNodeId(Fpdg->getNode(value).get());
+        if (valueNode != PDGSnapshot::INVALID_NODE) {
+            addSlice(valueNode, false, F, sensitive);
+        }
+    }
+}
+
+void RegionOutliner::addSlice(unsigned node, bool forward, llvm::Function* F, InstructionSet& sensitive) const
+{
+    // Slice is followed through callees, call sites and globals like the partitioner's slicer does,
+    // as values of F may come back from other functions, e.g. loaded after a callee stored through a pointer.
+    // Only instructions of F are collected.
+    std::vector<bool> visited(m_pdgSnapshot.size());
+    RingBuffer<unsigned> workingList;
+    visited[node] = true;
+    workingList.push(node);
+    const auto& visit = [&] (unsigned next) {
+        if (m_pdgSnapshot.canProcessNode(next) && !visited[next]) {
+            visited[next] = true;
+            workingList.push(next);
+        }
+    };
+    while (!workingList.empty()) {
+        const unsigned current = workingList.pop();
+        if (auto* I = llvm::dyn_cast_or_null<llvm::Instruction>(m_pdgSnapshot.getValue(current))) {
+            if (I->getFunction() == F) {
+                sensitive.insert(I);
+            }
+        }
+        if (forward && m_pdgSnapshot.getKind(current) == PDGSnapshot::ACTUAL_ARG
+                && m_pdgSnapshot.isPointerActualArg(current)) {
+            for (unsigned next : m_pdgSnapshot.getOutEdges(current)) {
+                if (m_pdgSnapshot.getKind(next) == PDGSnapshot::FORMAL_ARG) {
+                    visit(next);
+                }
+            }
+        }
+        const auto& edges = forward ? m_pdgSnapshot.getOutEdges(current) : m_pdgSnapshot.getInEdges(current);
+        for (unsigned next : edges) {
+            visit(next);
+        }
+    }
+}
+
+RegionOutliner::OutlineRegions RegionOutliner::findRegions(llvm::Function* F,
+                                                           const InstructionSet& sensitive,
+                                                           const llvm::BlockFrequencyInfo& blockFrequency,
+                                                           const llvm::TargetTransformInfo& targetTransformInfo) const
+{
+    std::unordered_set<llvm::BasicBlock*> sensitiveBlocks;
+    for (auto* I : sensitive) {
+        sensitiveBlocks.insert(I->getParent());
+    }
+    llvm::DominatorTree dominatorTree(*F);
+    llvm::PostDominatorTree postDominatorTree;
+    postDominatorTree.recalculate(*F);
+    llvm::DominanceFrontier dominanceFrontier;
+    dominanceFrontier.analyze(dominatorTree);
+    llvm::RegionInfo regionInfo;
+    regionInfo.recalculate(*F, &dominatorTree, &postDominatorTree, &dominanceFrontier);
+
+    OutlineRegions regions;
+    // The top level region is the whole function, which is not outlined
+    for (auto& subregion : *regionInfo.getTopLevelRegion()) {
+        findRegions(subregion.get(), sensitiveBlocks, blockFrequency, targetTransformInfo, regions);
+    }
+    return regions;
+}
+
+void RegionOutliner::findRegions(llvm::Region* region,
+                                 const std::unordered_set<llvm::BasicBlock*>& sensitiveBlocks,
+                                 const llvm::BlockFrequencyInfo& blockFrequency,
+                                 const llvm::TargetTransformInfo& targetTransformInfo,
+                                 OutlineRegions& regions) const
+{
+    bool isSensitive = false;
+    for (auto* B : region->blocks()) {
+        if (sensitiveBlocks.find(B) != sensitiveBlocks.end()) {
+            isSensitive = true;
+            break;
+        }
+    }
+    if (!isSensitive) {
+        OutlineRegion outlineRegion;
+        if (isWorthOutlining(region, blockFrequency, targetTransformInfo, outlineRegion)) {
+            regions.push_back(std::move(outlineRegion));
+            return;
+        }
+    }
+    // Smaller regions inside may still be worth it, e.g. a cold loop of a hot region
+    for (auto& subregion : *region) {
+        findRegions(subregion.get(), sensitiveBlocks, blockFrequency, targetTransformInfo, regions);
+    }
+}
+
+bool RegionOutliner::isWorthOutlining(llvm::Region* region,
+                                      const llvm::BlockFrequencyInfo& blockFrequency,
+                                      const llvm::TargetTransformInfo& targetTransformInfo,
+                                      OutlineRegion& outlineRegion) const
+{
+    long instructions = 0;
+    for (auto* B : region->blocks()) {
+        outlineRegion.blocks.push_back(B);
+        for (auto& I : *B) {
+            instructions += targetTransformInfo.getUserCost(&I);
+        }
+    }
+    outlineRegion.savedBytes = instructions * INSTRUCTION_BYTES - OCALL_STUB_BYTES;
+    if (outlineRegion.savedBytes < MIN_SAVED_BYTES) {
+        return false;
+    }
+    if (!llvm::CodeExtractor(outlineRegion.blocks).isEligible()) {
+        return false;
+    }
+    llvm::Function* F = region->getEntry()->getParent();
+    const double entryFrequency = blockFrequency.getEntryFreq();
+    const double regionFrequency = entryFrequency == 0
+            ? 1 : blockFrequency.getBlockFreq(region->getEntry()).getFrequency() / entryFrequency;
+    const double entries = regionFrequency * m_moduleFacts.getFunctionFrequency(F);
+    const double transitionCost = entries * (m_transitionNs + getMarshaledBytes(outlineRegion.blocks) * m_byteCopyNs);
+    return transitionCost < outlineRegion.savedBytes * OutlineByteNs;
+}
+
+long RegionOutliner::getMarshaledBytes(const Blocks& blocks) const
+{
+    llvm::SetVector<llvm::Value*> inputs;
+    llvm::SetVector<llvm::Value*> outputs;
+    llvm::SetVector<llvm::Value*> allocas;
+    llvm::CodeExtractor(blocks).findInputsOutputs(inputs, outputs, allocas);
+    const auto& dataLayout = m_module.getDataLayout();
+    const auto& getValueBytes = [&dataLayout] (llvm::Value* value) {
+        auto* type = value->getType();
+        long bytes = type->isSized() ? dataLayout.getTypeAllocSize(type) : 0;
+        // Enclave memory is not accessible outside, so pointees are copied out and back
+        if (auto* pointerType = llvm::dyn_cast<llvm::PointerType>(type)) {
+            if (pointerType->getElementType()->isSized()) {
+                bytes += 2 * dataLayout.getTypeAllocSize(pointerType->getElementType());
+            }
+        }
+        return bytes;
+    };
+    long bytes = 0;
+    for (auto* input : inputs) {
+        bytes += getValueBytes(input);
+    }
+    for (auto* output : outputs) {
+        bytes += getValueBytes(output);
+    }
+    return bytes;
+}
+
+unsigned RegionOutliner::outline(llvm::Function* F, const OutlineRegions& regions)
+{
+    unsigned outlined = 0;
+    for (const auto& region : regions) {
+        llvm::CodeExtractor extractor(region.blocks);
+        if (!extractor.isEligible()) {
+            continue;
+        }
+        auto* outlinedF = extractor.extractCodeRegion();
+        if (!outlinedF) {
+            m_logger.warn("Failed to outline region of " + F->getName().str());
+            continue;
+        }
+        m_logger.info("Outlined " + outlinedF->getName().str() + " of "
+                      + std::to_string(region.savedBytes) + " bytes from " + F->getName().str());
+        m_savedBytes += region.savedBytes;
+        ++outlined;
+    }
+    return outlined;
+}
+
+char RegionOutlinerPass::ID = 0;
+
+void RegionOutlinerPass::getAnalysisUsage(llvm::AnalysisUsage& AU) const
+{
+    AU.addRequired<pdg::SVFGPDGBuilder>();
+    AU.addRequired<llvm::LoopInfoWrapperPass>();
+    AU.addRequired<llvm::BlockFrequencyInfoWrapperPass>();
+    AU.addRequired<llvm::ScalarEvolutionWrapperPass>();
+    AU.addRequired<llvm::TargetTransformInfoWrapperPass>();
+}
+
+bool RegionOutlinerPass::runOnModule(llvm::Module& M)
+{
+    Logger logger("region-outliner");
+    logger.setLevel(vazgen::Logger::INFO);
+
+    AnnotationParser* annotationParser;
+    if (!JsonAnnotations.empty()) {
+        annotationParser = new JsonAnnotationParser(&M, JsonAnnotations, logger);
+    } else {
+        annotationParser = new ModuleAnnotationParser(&M, logger);
+    }
+    annotationParser->parseAnnotations();
+    const auto& annotations = annotationParser->getAllAnnotations();
+
+    auto pdg = getAnalysis<pdg::SVFGPDGBuilder>().getPDG();
+    const auto& analysesGetter = [this] (llvm::Function* F)
+        {
+            auto& loopPass = this->getAnalysis<llvm::LoopInfoWrapperPass>(*F);
+            auto& blockFrequencyPass = this->getAnalysis<llvm::BlockFrequencyInfoWrapperPass>(*F);
+            auto& scalarEvolutionPass = this->getAnalysis<llvm::ScalarEvolutionWrapperPass>(*F);
+            ModuleFacts::FunctionAnalyses analyses;
+            analyses.loopInfo = &loopPass.getLoopInfo();
+            analyses.blockFrequency = &blockFrequencyPass.getBFI();
+            analyses.scalarEvolution = &scalarEvolutionPass.getSE();
+            analyses.targetTransformInfo = &this->getAnalysis<llvm::TargetTransformInfoWrapperPass>().getTTI(*F);
+            return analyses;
+        };
+    ModuleFacts moduleFacts(M, *pdg, analysesGetter, logger);
+    PDGSnapshot pdgSnapshot(M, *pdg, moduleFacts.getFunctionIndex());
+    RegionOutliner outliner(M, pdg, pdgSnapshot, moduleFacts, logger);
+
+    // All regions are found before any is outlined, as outlining changes the functions the PDG was built for
+    std::vector<std::pair<llvm::Function*, RegionOutliner::OutlineRegions>> functionRegions;
+    std::unordered_set<llvm::Function*> processed;
+    for (const auto& annotation : annotations) {
+        llvm::Function* F = annotation.getFunction();
+        if (!F || F->isDeclaration() || annotation.isPerformanceHint()) {
+            continue;
+        }
+        // Annotation of the function alone makes all of it sensitive
+        if (!annotation.hasAnnotatedArguments() && !annotation.isReturnAnnotated()) {
+            continue;
+        }
+        if (!processed.insert(F).second) {
+            continue;
+        }
+        RegionOutliner::InstructionSet sensitive;
+        for (const auto& otherAnnotation : annotations) {
+            if (otherAnnotation.getFunction() == F) {
+                outliner.collectSensitiveInstructions(otherAnnotation, sensitive);
+            }
+        }
+        auto& blockFrequencyPass = getAnalysis<llvm::BlockFrequencyInfoWrapperPass>(*F);
+        const auto& targetTransformInfo = getAnalysis<llvm::TargetTransformInfoWrapperPass>().getTTI(*F);
+        auto regions = outliner.findRegions(F, sensitive, blockFrequencyPass.getBFI(), targetTransformInfo);
+        if (!regions.empty()) {
+            functionRegions.push_back(std::make_pair(F, std::move(regions)));
+        }
+    }
+    unsigned outlined = 0;
+    for (const auto& [F, regions] : functionRegions) {
+        outlined += outliner.outline(F, regions);
+    }
+    logger.info("Outlined " + std::to_string(outlined) + " non-sensitive regions, "
+                + std::to_string(outliner.getSavedBytes()) + " bytes of enclave code");
+    return outlined != 0;
+}
+
+static llvm::RegisterPass<RegionOutlinerPass> X("outline-non-sensitive","Outline non-sensitive regions of annotated functions");
+
+} // namespace vazgen
+
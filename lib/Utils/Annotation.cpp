@@ -5,6 +5,11 @@
 
 namespace vazgen {
 
+const std::string Annotation::PIN_ENCLAVE = "pin-enclave";
+const std::string Annotation::PIN_UNTRUSTED = "pin-untrusted";
+const std::string Annotation::CALL_RATE = "call-rate";
+const std::string Annotation::LATENCY_CRITICAL = "latency-critical";
+
 void Annotation::dump() const
 {
     llvm::dbgs() << "--------- Annotation " << m_annotation << "\n";
@@ -15,6 +20,12 @@ void Annotation::dump() const
     if (m_return) {
         llvm::dbgs() << " return";
     }
+    if (m_annotation == CALL_RATE) {
+        llvm::dbgs() << " rate " << m_callRate;
+    }
+    for (auto* caller : m_latencyCriticalCallers) {
+        llvm::dbgs() << " caller " << caller->getName();
+    }
     llvm::dbgs() << "\n";
 }
 
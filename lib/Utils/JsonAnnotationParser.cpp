@@ -55,6 +55,26 @@ void JsonAnnotationParser::parseAnnotations()
             if (annot_return != annot_f.end()) {
                 annot.setReturnAnnotation(true);
             }
+            auto annot_rate = annot_f.find("rate");
+            if (annot_rate != annot_f.end()) {
+                annot.setCallRate(annot_rate->get<double>());
+            }
+            auto annot_callers = annot_f.find("callers");
+            if (annot_callers != annot_f.end()) {
+                for (auto& caller_item : *annot_callers) {
+                    const std::string caller_name = caller_item;
+                    auto* caller = m_module->getFunction(caller_name);
+                    if (!caller) {
+                        m_logger.error("Can not find caller with name " + caller_name + "\n");
+                        continue;
+                    }
+                    annot.addLatencyCriticalCaller(caller);
+                }
+            }
+            if (annotation_str == Annotation::CALL_RATE && annot.getCallRate() <= 0) {
+                m_logger.error("No positive call rate for function " + function_name + "\n");
+                continue;
+            }
             m_annotations[annotation_str].insert(annot);
         }
     }
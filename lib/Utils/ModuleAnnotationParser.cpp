@@ -7,6 +7,8 @@
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/Debug.h"
 
+#include <cstdlib>
+
 namespace vazgen {
 
 ModuleAnnotationParser::ModuleAnnotationParser(llvm::Module* module,
@@ -34,8 +36,46 @@ void ModuleAnnotationParser::parseAnnotations()
             if (!str_annotation) {
                 continue;
             }
-            const std::string annotation = str_annotation->getAsCString();
-            m_annotations[annotation].insert(Annotation(annotation, fn));
+            std::string annotation = str_annotation->getAsCString();
+            // Hints with values are written as name=value, e.g. call-rate=1000
+            std::string value;
+            const auto valuePos = annotation.find('=');
+            if (valuePos != std::string::npos) {
+                value = annotation.substr(valuePos + 1);
+                annotation = annotation.substr(0, valuePos);
+            }
+            Annotation annot(annotation, fn);
+            if (annotation == Annotation::CALL_RATE) {
+                const double rate = std::strtod(value.c_str(), nullptr);
+                if (rate <= 0) {
+                    m_logger.error("No positive call rate for function " + fn->getName().str());
+                    continue;
+                }
+                annot.setCallRate(rate);
+            } else if (annotation == Annotation::LATENCY_CRITICAL && !value.empty()) {
+                auto* caller = m_module->getFunction(value);
+                if (!caller) {
+                    m_logger.error("Can not find caller with name " + value);
+                    continue;
+                }
+                annot.addLatencyCriticalCaller(caller);
+                // Each caller comes in its own annotation string, they are merged into one annotation
+                auto& annotations = m_annotations[annotation];
+                auto pos = annotations.find(annot);
+                if (pos != annotations.end()) {
+                    if (pos->getLatencyCriticalCallers().empty()) {
+                        continue;
+                    }
+                    for (auto* otherCaller : pos->getLatencyCriticalCallers()) {
+                        annot.addLatencyCriticalCaller(otherCaller);
+                    }
+                    annotations.erase(pos);
+                }
+            } else if (annotation == Annotation::LATENCY_CRITICAL) {
+                // All calls are critical, this subsumes annotations for single callers
+                m_annotations[annotation].erase(annot);
+            }
+            m_annotations[annotation].insert(annot);
         }
     }
 }
@@ -1,5 +1,9 @@
 #include "Utils/PartitionUtils.h"
 
+#include "Analysis/LibraryCalls.h"
+#include "Analysis/ModuleFacts.h"
+#include "Utils/Logger.h"
+
 #include "PDG/PDG/PDG.h"
 #include "PDG/PDG/PDGNode.h"
 #include "PDG/PDG/PDGEdge.h"
@@ -7,18 +11,31 @@
 
 #include "llvm/IR/Function.h"
 #include "llvm/IR/CallSite.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
 
+llvm::cl::opt<bool> VerifyInterfaces(
+    "verify-partition-interfaces",
+    llvm::cl::desc("Check incrementally maintained partition interfaces against recomputed ones"),
+    llvm::cl::value_desc("flag to verify interfaces"));
+
+llvm::cl::opt<unsigned> ThreadsNum(
+    "partition-threads",
+    llvm::cl::desc("Number of threads used by partitioning analyses. 0 means hardware concurrency"),
+    llvm::cl::value_desc("threads number"),
+    llvm::cl::init(0));
+
 namespace vazgen {
 
 PartitionUtils::FunctionSet
 PartitionUtils::computeInInterface(const FunctionSet& functions,
                                    const pdg::PDG& pdg)
 {
-    FunctionSet inInterface;
+    FunctionSet inInterface(functions.getIndex());
+    const auto& libraryCalls = LibraryCalls::get();
     for (const auto& F : functions) {
-        if (!F) {
+        if (!F || libraryCalls.isEnclaveSafe(F)) {
             continue;
         }
         if (!pdg.hasFunctionPDG(F)) {
@@ -29,7 +46,7 @@ PartitionUtils::computeInInterface(const FunctionSet& functions,
         const auto& callSites = Fpdg->getCallSites();
         for (const auto& callSite : callSites) {
             auto* caller = callSite.getCaller();
-            if (functions.find(caller) == functions.end()) {
+            if (!functions.contains(caller)) {
                 inInterface.insert(F);
                 break;
             }
@@ -42,7 +59,8 @@ PartitionUtils::FunctionSet
 PartitionUtils::computeOutInterface(const FunctionSet& functions,
                                     const pdg::PDG& pdg)
 {
-    FunctionSet outInterface;
+    FunctionSet outInterface(functions.getIndex());
+    const auto& libraryCalls = LibraryCalls::get();
     for (const auto& F : functions) {
         if (!F) {
             continue;
@@ -68,7 +86,7 @@ PartitionUtils::computeOutInterface(const FunctionSet& functions,
                 if (auto* functionNode =
                         llvm::dyn_cast<pdg::PDGLLVMFunctionNode>((*edgeIt)->getDestination().get())) {
                     llvm::Function* outF = functionNode->getFunction();
-                    if (functions.find(outF) == functions.end()) {
+                    if (!functions.contains(outF) && !libraryCalls.isEnclaveSafe(outF)) {
                         outInterface.insert(outF);
                     }
                 }
@@ -78,5 +96,71 @@ PartitionUtils::computeOutInterface(const FunctionSet& functions,
     return outInterface;
 }
 
-} // namespace vazgen
+Partition::InterfaceGraphType
+PartitionUtils::computeInterfaceGraph(const pdg::PDG& pdg,
+                                      const ModuleFacts& moduleFacts)
+{
+    // Enclave safe declarations are called in place from both partitions, so they are in no interface
+    auto graph = std::make_shared<InterfaceGraph>(moduleFacts.getFunctionIndex());
+    const auto& libraryCalls = LibraryCalls::get();
+    for (const auto& [F, Fpdg] : pdg.getFunctionPDGs()) {
+        if (!F) {
+            continue;
+        }
+        if (!libraryCalls.isEnclaveSafe(F)) {
+            for (const auto& callSite : moduleFacts.getCallSites(F)) {
+                graph->addInInterfaceEdge(callSite.caller, F);
+            }
+        }
+        for (auto it = Fpdg->llvmNodesBegin(); it != Fpdg->llvmNodesEnd(); ++it) {
+            llvm::Value* val = it->first;
+            if (!llvm::dyn_cast<llvm::CallInst>(val)
+                    && !llvm::dyn_cast<llvm::InvokeInst>(val)) {
+                continue;
+            }
+            for (auto edgeIt = it->second->outEdgesBegin();
+                    edgeIt != it->second->outEdgesEnd();
+                    ++edgeIt) {
+                if (!(*edgeIt)->isControlEdge()) {
+                    continue;
+                }
+                if (auto* functionNode =
+                        llvm::dyn_cast<pdg::PDGLLVMFunctionNode>((*edgeIt)->getDestination().get())) {
+                    if (!libraryCalls.isEnclaveSafe(functionNode->getFunction())) {
+                        graph->addOutInterfaceEdge(F, functionNode->getFunction());
+                    }
+                }
+            }
+        }
+    }
+    return graph;
+}
 
+bool PartitionUtils::verifyInterfaces(const Partition& partition,
+                                      const pdg::PDG& pdg,
+                                      Logger& logger)
+{
+    if (!VerifyInterfaces) {
+        return true;
+    }
+    bool valid = true;
+    if (partition.getInInterface() != computeInInterface(partition.getPartition(), pdg)) {
+        logger.error("Incrementally maintained in interface differs from the recomputed one");
+        valid = false;
+    }
+    if (partition.getOutInterface() != computeOutInterface(partition.getPartition(), pdg)) {
+        logger.error("Incrementally maintained out interface differs from the recomputed one");
+        valid = false;
+    }
+    return valid;
+}
+
+unsigned PartitionUtils::getThreadsNum()
+{
+    if (ThreadsNum != 0) {
+        return ThreadsNum;
+    }
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+} // namespace vazgen